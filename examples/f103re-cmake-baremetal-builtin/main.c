@@ -1,11 +1,72 @@
 #include <stm32f103xe.h>
 #include "stdio.h"
 #include "runit.h"
+#include "SEGGER_RTT.h"
+
+// Hang detection: SysTick feeds the independent watchdog only while the test case being run is within its time limit,
+// otherwise the watchdog resets the target; also when the interrupts are stuck. The HardFault handler of runit resets
+// the target at once. The progress of the run survives those resets in the .noinit section, so main() can report the
+// test case and go on after it.
+#define TEST_TIMEOUT_MS  2000U
+#define TOTAL_TIMEOUT_MS 60000U
+
+static runit_persistent_t persistent RUNIT_NOINIT;
+static volatile uint32_t  run_ms RUNIT_NOINIT;  // Of the whole run, counted on over the resets
+static volatile char      watching;             // Set by watchdog_start(), the state is kept until then
 
 static volatile uint64_t s_ticks;  // Milliseconds since boot
 void                     SysTick_Handler(void)
 {  // SyStick IRQ handler, triggered every 1ms
+    static size_t   last  = RUNIT_NO_TEST;
+    static uint64_t since = 0;
+    const size_t    test  = runit_current_test();
+    uint32_t        cause[3];
+
     s_ticks++;
+    if (!watching)
+    {
+        return;
+    }
+    run_ms++;
+    if (test != last)
+    {
+        last  = test;
+        since = s_ticks;
+    }
+    cause[0] = (uint32_t) (s_ticks - since);
+    cause[1] = run_ms >= TOTAL_TIMEOUT_MS ? TOTAL_TIMEOUT_MS : TEST_TIMEOUT_MS;
+    cause[2] = run_ms >= TOTAL_TIMEOUT_MS;
+    if (test == RUNIT_NO_TEST || (cause[0] < TEST_TIMEOUT_MS && !cause[2]))
+    {
+        IWDG->KR = 0xAAAA;  // Feed the watchdog
+    }
+    else if (watching == 1)
+    {
+        runit_persist_cause(RUNIT_KIND_TIMEOUT, cause, 3U);
+        watching = 2;  // Noted once, the watchdog resets the target soon
+    }
+}
+
+// Resets the target about 100 ms after the last feeding; cannot be stopped once started
+static void watchdog_start(void)
+{
+    IWDG->KR  = 0xCCCC;  // Start, on the LSI oscillator at about 40 kHz
+    IWDG->KR  = 0x5555;  // Unlock the prescaler and reload registers
+    IWDG->PR  = 3;       // Divide by 32: 0.8 ms per count
+    IWDG->RLR = 125;
+    while (IWDG->SR != 0)
+    {
+    }
+    IWDG->KR = 0xAAAA;
+    watching = 1;
+}
+
+// Pushes each runit line to RTT with one call, instead of one character at a time through newlib
+static void rtt_sink(void* context, const char* record, size_t length)
+{
+    (void) context;
+    fflush(stdout);  // Keep the order with the "Expected failure: " prefix printed through stdio
+    SEGGER_RTT_Write(0, record, length);
 }
 
 static size_t expected_failures_counter = 0;
@@ -20,88 +81,88 @@ static void test_initially_no_test_have_failed(void)
     runit_eq(runit_at_least_one_fail, 0);
 }
 
-static void test_assert(void)
+RUNIT_TEST(test_assert)
 {
     runit_assert(1);
     SHOULD_FAIL(runit_assert(0));
 }
 
-static void test_true(void)
+RUNIT_TEST(test_true)
 {
     runit_true(1);
     SHOULD_FAIL(runit_true(0));
 }
 
-static void test_false(void)
+RUNIT_TEST(test_false)
 {
     runit_false(3000 < 0);
     runit_false(0);
     SHOULD_FAIL(runit_false(1));
 }
 
-static void test_eq(void)
+RUNIT_TEST(test_eq)
 {
     runit_eq(12, 12);
     runit_eq(12.0f, 12U);
     SHOULD_FAIL(runit_eq(100, 1));
 }
 
-static void test_neq(void)
+RUNIT_TEST(test_neq)
 {
     runit_neq(100, 1);
     SHOULD_FAIL(runit_neq(12, 12));
 }
 
-static void test_neq_casting(void)
+RUNIT_TEST(test_neq_casting)
 {
     SHOULD_FAIL(runit_neq(12.0f, 12U));
 }
 
-static void test_gt(void)
+RUNIT_TEST(test_gt)
 {
     runit_gt(100, 1);
     SHOULD_FAIL(runit_gt(1, 100));
 }
 
-static void test_gt_equality(void)
+RUNIT_TEST(test_gt_equality)
 {
     SHOULD_FAIL(runit_gt(100, 100));
 }
 
-static void test_ge(void)
+RUNIT_TEST(test_ge)
 {
     runit_ge(100, 1);
     SHOULD_FAIL(runit_ge(1, 100));
 }
 
-static void test_ge_equality(void)
+RUNIT_TEST(test_ge_equality)
 {
     runit_ge(100, 100);
 }
 
-static void test_lt(void)
+RUNIT_TEST(test_lt)
 {
     runit_lt(1, 100);
     SHOULD_FAIL(runit_lt(100, 1));
 }
 
-static void test_lt_equality(void)
+RUNIT_TEST(test_lt_equality)
 {
     SHOULD_FAIL(runit_lt(100, 100));
 }
 
-static void test_le(void)
+RUNIT_TEST(test_le)
 {
     runit_le(1, 100);
     SHOULD_FAIL(runit_le(100, 1));
 }
 
-static void test_le_equality(void)
+RUNIT_TEST(test_le_equality)
 {
     runit_le(100, 100);
 }
 
-static void test_fapprox(void)
+RUNIT_TEST(test_fapprox)
 {
     runit_fapprox(1.0f, 1.0f);
     runit_fapprox(1.0f, 1U);
@@ -109,7 +170,7 @@ static void test_fapprox(void)
     SHOULD_FAIL(runit_fapprox(1.0f, 1.1f));
 }
 
-static void test_fdelta(void)
+RUNIT_TEST(test_fdelta)
 {
     runit_fdelta(1.0f, 1.0f, 0.01f);
     runit_fdelta(1.0f, 1.1f, 0.15f);
@@ -118,7 +179,7 @@ static void test_fdelta(void)
     SHOULD_FAIL(runit_fdelta(1.0f, 1.1f, 0.01f));
 }
 
-static void test_fdelta_negatives(void)
+RUNIT_TEST(test_fdelta_negatives)
 {
     runit_fdelta(-1.0f, -1.0f, 0.01f);
     runit_fdelta(-1.0f, -1.0f, -0.01f);
@@ -129,7 +190,7 @@ static void test_fdelta_negatives(void)
     SHOULD_FAIL(runit_fdelta(-1.0f, -1.1f, 0.01f));
 }
 
-static void test_dapprox(void)
+RUNIT_TEST(test_dapprox)
 {
     runit_dapprox(1.0, 1.0);
     runit_dapprox(1.0, 1U);
@@ -137,7 +198,7 @@ static void test_dapprox(void)
     SHOULD_FAIL(runit_dapprox(1.0, 1.1));
 }
 
-static void test_ddelta(void)
+RUNIT_TEST(test_ddelta)
 {
     runit_ddelta(1.0, 1.1, 0.15);
     runit_ddelta(1.0, 1.0, 0.01);
@@ -145,7 +206,7 @@ static void test_ddelta(void)
     SHOULD_FAIL(runit_ddelta(1.0, 1.1, 0.01));
 }
 
-static void test_ddelta_negatives(void)
+RUNIT_TEST(test_ddelta_negatives)
 {
     runit_ddelta(-1.0, -1.0, 0.01);
     runit_ddelta(-1.0, -1.0, -0.01);
@@ -156,94 +217,94 @@ static void test_ddelta_negatives(void)
     SHOULD_FAIL(runit_ddelta(-1.0, -1.1, 0.01));
 }
 
-static void test_nan(void)
+RUNIT_TEST(test_nan)
 {
     runit_nan(NAN);
     runit_nan(nan(""));
     runit_nan(nanf(""));
 }
 
-static void test_nan_finite_float(void)
+RUNIT_TEST(test_nan_finite_float)
 {
     SHOULD_FAIL(runit_nan(1.0f));
 }
 
-static void test_nan_finite_double(void)
+RUNIT_TEST(test_nan_finite_double)
 {
     SHOULD_FAIL(runit_nan(1.0));
 }
 
-static void test_nan_infinity(void)
+RUNIT_TEST(test_nan_infinity)
 {
     SHOULD_FAIL(runit_nan(INFINITY));
 }
 
-static void test_inf(void)
+RUNIT_TEST(test_inf)
 {
     runit_inf(INFINITY);
     runit_inf(+INFINITY);
     runit_inf(-INFINITY);
 }
 
-static void test_inf_finite_float(void)
+RUNIT_TEST(test_inf_finite_float)
 {
     SHOULD_FAIL(runit_inf(1.0f));
 }
 
-static void test_inf_finite_double(void)
+RUNIT_TEST(test_inf_finite_double)
 {
     SHOULD_FAIL(runit_inf(1.0));
 }
 
-static void test_inf_nan(void)
+RUNIT_TEST(test_inf_nan)
 {
     SHOULD_FAIL(runit_inf(NAN));
 }
 
-static void test_plusinf(void)
+RUNIT_TEST(test_plusinf)
 {
     runit_plusinf(INFINITY);
     runit_plusinf(+INFINITY);
     SHOULD_FAIL(runit_plusinf(-INFINITY));
 }
 
-static void test_plusinf_finite_float(void)
+RUNIT_TEST(test_plusinf_finite_float)
 {
     SHOULD_FAIL(runit_plusinf(1.0f));
 }
 
-static void test_plusinf_finite_double(void)
+RUNIT_TEST(test_plusinf_finite_double)
 {
     SHOULD_FAIL(runit_plusinf(1.0));
 }
 
-static void test_plusinf_nan(void)
+RUNIT_TEST(test_plusinf_nan)
 {
     SHOULD_FAIL(runit_plusinf(NAN));
 }
 
-static void test_minusinf(void)
+RUNIT_TEST(test_minusinf)
 {
     runit_minusinf(-INFINITY);
     SHOULD_FAIL(runit_minusinf(INFINITY));
 }
 
-static void test_minusinf_finite_float(void)
+RUNIT_TEST(test_minusinf_finite_float)
 {
     SHOULD_FAIL(runit_minusinf(1.0f));
 }
 
-static void test_minusinf_finite_double(void)
+RUNIT_TEST(test_minusinf_finite_double)
 {
     SHOULD_FAIL(runit_minusinf(1.0));
 }
 
-static void test_minusinf_nan(void)
+RUNIT_TEST(test_minusinf_nan)
 {
     SHOULD_FAIL(runit_minusinf(NAN));
 }
 
-static void test_notfinite(void)
+RUNIT_TEST(test_notfinite)
 {
     runit_notfinite(INFINITY);
     runit_notfinite(+INFINITY);
@@ -253,17 +314,17 @@ static void test_notfinite(void)
     runit_notfinite(nan(""));
 }
 
-static void test_notfinite_finite_float(void)
+RUNIT_TEST(test_notfinite_finite_float)
 {
     SHOULD_FAIL(runit_notfinite(1.0f));
 }
 
-static void test_notfinite_finite_double(void)
+RUNIT_TEST(test_notfinite_finite_double)
 {
     SHOULD_FAIL(runit_notfinite(1.0));
 }
 
-static void test_finite(void)
+RUNIT_TEST(test_finite)
 {
     runit_finite(0.0f);
     runit_finite(-0.0f);
@@ -275,32 +336,32 @@ static void test_finite(void)
     runit_finite(-1.0);
 }
 
-static void test_finite_plusinf(void)
+RUNIT_TEST(test_finite_plusinf)
 {
     SHOULD_FAIL(runit_finite(INFINITY));
 }
 
-static void test_finite_minusinf(void)
+RUNIT_TEST(test_finite_minusinf)
 {
     SHOULD_FAIL(runit_finite(-INFINITY));
 }
 
-static void test_finite_nan_macro(void)
+RUNIT_TEST(test_finite_nan_macro)
 {
     SHOULD_FAIL(runit_finite(NAN));
 }
 
-static void test_finite_nan_call(void)
+RUNIT_TEST(test_finite_nan_call)
 {
     SHOULD_FAIL(runit_finite(nan("")));
 }
 
-static void test_finite_nanf_call(void)
+RUNIT_TEST(test_finite_nanf_call)
 {
     SHOULD_FAIL(runit_finite(nanf("")));
 }
 
-static void test_flag(void)
+RUNIT_TEST(test_flag)
 {
     runit_flag(1, 1);
     runit_flag(0xFF, 1);
@@ -316,14 +377,14 @@ static void test_flag(void)
     SHOULD_FAIL(runit_flag(0x07, 0xF0));
 }
 
-static void test_flag_when_none(void)
+RUNIT_TEST(test_flag_when_none)
 {
     /* runit_flag() checks for flag presence. To check for their absence,
      * runit_noflag() should be used instead; or even runit_eq(flags, 0). */
     SHOULD_FAIL(runit_flag(0, 0));
 }
 
-static void test_noflag(void)
+RUNIT_TEST(test_noflag)
 {
     runit_noflag(0, 1);
     runit_noflag(2, 1);
@@ -336,7 +397,7 @@ static void test_noflag(void)
     SHOULD_FAIL(runit_noflag(0x07, 0x04));
 }
 
-static void test_streq(void)
+RUNIT_TEST(test_streq)
 {
     const char a[] = "hello";
     const char b[] = "hello";
@@ -354,7 +415,7 @@ static void test_streq(void)
     SHOULD_FAIL(runit_streq(a, c, 5));
 }
 
-static void test_memeq(void)
+RUNIT_TEST(test_memeq)
 {
     const uint8_t a[] = {255, 255, 255, 255, 255};
     const uint8_t b[] = {255, 255, 255, 255, 255};
@@ -372,7 +433,7 @@ static void test_memeq(void)
     SHOULD_FAIL(runit_memeq(c, a, 5));
 }
 
-static void test_memneq(void)
+RUNIT_TEST(test_memneq)
 {
     const uint8_t a[] = {255, 255, 255, 255, 255};
     const uint8_t b[] = {255, 255, 255, 255, 255};
@@ -389,7 +450,7 @@ static void test_memneq(void)
     SHOULD_FAIL(runit_memneq(a, b, 5));
 }
 
-static void test_zeros(void)
+RUNIT_TEST(test_zeros)
 {
     const uint8_t  a[] = {0, 0, 0, 0, 0};
     const uint8_t  b[] = {0, 0, 255, 255, 255};
@@ -407,7 +468,7 @@ static void test_zeros(void)
     SHOULD_FAIL(runit_zeros(b, 5U));
 }
 
-static void test_nzeros(void)
+RUNIT_TEST(test_nzeros)
 {
     const uint8_t a[] = {0, 0, 0, 0, 0};
     const uint8_t b[] = {0, 0, 255, 255, 255};
@@ -426,82 +487,70 @@ static void test_nzeros(void)
     SHOULD_FAIL(runit_nzeros(a, 5U));
 }
 
-static void test_fail(void)
+RUNIT_TEST(test_fail)
 {
     SHOULD_FAIL(runit_fail());
 }
 
+RUNIT_TEST(bench_memcmp)
+{
+    static unsigned char a[256];
+    static unsigned char b[256];
+
+    RUNIT_BENCH(memcmp_256)
+    {
+        RUNIT_BENCH_KEEP(memcmp(a, b, sizeof(a)));
+    }
+}
+
+#if defined(EXAMPLE_HANG)
+RUNIT_TEST(test_hang)
+{  // Stopped by the watchdog, the run goes on after it
+    for (;;)
+    {
+    }
+}
+#endif
+
+#if defined(EXAMPLE_HARDFAULT)
+RUNIT_TEST(test_hardfault)
+{  // Reads past the end of the 64 KiB of SRAM: a BusFault, escalated to a HardFault
+    runit_eq(*(volatile uint32_t*) 0x20010000U, 0U);
+}
+#endif
+
 static void test_at_the_end_some_tests_have_failed(void)
 {
     runit_eq(runit_at_least_one_fail, 1);
 }
 
-static void start_self_tests(void)
-{
-    test_initially_no_test_have_failed();
-    test_assert();
-    test_true();
-    test_false();
-    test_eq();
-    test_neq();
-    test_neq_casting();
-    test_gt();
-    test_gt_equality();
-    test_ge();
-    test_ge_equality();
-    test_lt();
-    test_lt_equality();
-    test_le();
-    test_le_equality();
-    test_fapprox();
-    test_fdelta();
-    test_fdelta_negatives();
-    test_dapprox();
-    test_ddelta();
-    test_ddelta_negatives();
-    test_nan();
-    test_nan_finite_float();
-    test_nan_finite_double();
-    test_nan_infinity();
-    test_inf();
-    test_inf_finite_float();
-    test_inf_finite_double();
-    test_inf_nan();
-    test_plusinf();
-    test_plusinf_finite_float();
-    test_plusinf_finite_double();
-    test_plusinf_nan();
-    test_minusinf();
-    test_minusinf_finite_float();
-    test_minusinf_finite_double();
-    test_minusinf_nan();
-    test_notfinite();
-    test_notfinite_finite_float();
-    test_notfinite_finite_double();
-    test_finite();
-    test_finite_plusinf();
-    test_finite_minusinf();
-    test_finite_nan_macro();
-    test_finite_nanf_call();
-    test_finite_nan_call();
-    test_flag();
-    test_flag_when_none();
-    test_noflag();
-    test_streq();
-    test_memeq();
-    test_memneq();
-    test_zeros();
-    test_nzeros();
-    test_fail();
+static void start_self_tests(size_t first)
+{
+    // These two depend on the order, the others are found in the runit_tests section
+    if (first == 0)
+    {
+        test_initially_no_test_have_failed();
+    }
+    runit_run_from(first);
     test_at_the_end_some_tests_have_failed();
     runit_report();
 }
 
 int main(void)
 {
-    start_self_tests();
-    
-    if (expected_failures_counter != runit_counter_assert_failures)
+    size_t first;
+
+    runit_set_sink(rtt_sink, NULL);
+    first = runit_resume(&persistent);  // Reports the test case stopped by a reset, if any
+    if (first == 0)
+    {
+        run_ms = 0;  // A new run, not resumed: the .noinit value is stale or random
+    }
+    watchdog_start();
+    start_self_tests(first);
+    if (first > 0)  // The counters of runit are restored, expected_failures_counter is not
+        printf("Resumed after a reset, the expected failures are not checked\n");
+    else if (expected_failures_counter != runit_counter_assert_failures)
         printf("Expected %u failures, but got %u\n", expected_failures_counter, runit_counter_assert_failures);
     else
         printf("All tests passed successfully!\n");
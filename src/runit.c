@@ -5,8 +5,2987 @@
  *
  */
 
-#include "stddef.h"
+#if !defined(_DEFAULT_SOURCE)
+#    define _DEFAULT_SOURCE /* For MAP_ANONYMOUS */
+#endif
+
+#include "runit.h"
+#include <stdint.h> /* For uint8_t, uint32_t, intptr_t */
+#include <stdlib.h> /* For strtoul() */
+#include <string.h> /* For memcpy() */
+#include <time.h>   /* For clock(), clock_gettime() */
+#if defined(__AVX__)
+#    include <immintrin.h>
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#    include <arm_neon.h>
+#endif
+#if RUNIT_HAVE_SINK_FD
+#    include <errno.h>  /* For EINTR */
+#    include <unistd.h> /* For write() */
+#endif
+#if RUNIT_HAVE_CRASH_RECOVERY
+#    include <setjmp.h>   /* For sigsetjmp(), siglongjmp() */
+#    include <signal.h>   /* For sigaction(), sigaltstack(), raise() */
+#    include <sys/time.h> /* For setitimer() */
+#    include <unistd.h>   /* For _exit() */
+#endif
+#if RUNIT_HAVE_PARALLEL
+#    include <errno.h> /* For EINTR */
+#    include <stdatomic.h>
+#    include <sys/mman.h> /* For mmap() */
+#    include <sys/wait.h> /* For waitpid() */
+#    include <unistd.h>   /* For fork(), sysconf() */
+#endif
 
 char         runit_at_least_one_fail       = 0;
 unsigned int runit_counter_assert_failures = 0;
 unsigned int runit_counter_assert_passes   = 0;
+
+/* Failures of the runit_expect_*() assertions printed in this test case. */
+#if defined(RUNIT_THREAD_SAFE)
+static _Thread_local unsigned int runit_expect_recorded = 0;
+#else
+static unsigned int runit_expect_recorded = 0;
+#endif
+
+#if defined(RUNIT_THREAD_SAFE)
+/* Counters of one thread on their own cache line, to avoid false sharing. */
+typedef struct runit_slot
+{
+    _Alignas(64) runit_counters_t counters;
+} runit_slot_t;
+
+_Thread_local runit_counters_t* runit_thread_counters_ = NULL;
+
+static _Thread_local char runit_thread_unslotted = 0; /* All slots were taken */
+static runit_slot_t       runit_slots[RUNIT_THREAD_SLOTS];
+static runit_slot_t       runit_slot_shared; /* For the threads without slot */
+static atomic_uint        runit_slots_claimed = 0;
+
+static runit_counters_t* runit_claim_slot(void)
+{
+    if (!runit_thread_unslotted)
+    {
+        const unsigned int index = atomic_fetch_add_explicit(&runit_slots_claimed, 1U, memory_order_relaxed);
+        if (index < RUNIT_THREAD_SLOTS)
+        {
+            runit_thread_counters_ = &runit_slots[index].counters;
+        }
+        else
+        {
+            runit_thread_unslotted = 1;
+        }
+    }
+    return runit_thread_counters_;
+}
+
+/* Counts one pass or one failure of the current thread. */
+static void runit_count(const int failure)
+{
+    runit_counters_t* counters = runit_thread_counters_;
+
+    if (counters == NULL)
+    {
+        counters = runit_claim_slot();
+    }
+    if (counters != NULL)
+    {
+        atomic_uint* const counter = failure ? &counters->failures : &counters->passes;
+        atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + 1U, memory_order_relaxed);
+    }
+    else
+    {
+        atomic_uint* const counter = failure ? &runit_slot_shared.counters.failures : &runit_slot_shared.counters.passes;
+        atomic_fetch_add_explicit(counter, 1U, memory_order_relaxed);
+    }
+}
+
+void runit_count_pass_slow_(void)
+{
+    runit_count(0);
+}
+#endif
+
+void runit_counters_merge(void)
+{
+#if defined(RUNIT_THREAD_SAFE)
+    static atomic_flag  lock            = ATOMIC_FLAG_INIT;
+    static unsigned int merged_passes   = 0; /* Sums at the previous merge */
+    static unsigned int merged_failures = 0;
+    unsigned int        claimed;
+    unsigned int        passes;
+    unsigned int        failures;
+
+    while (atomic_flag_test_and_set_explicit(&lock, memory_order_acquire))
+    {
+    }
+    claimed  = atomic_load_explicit(&runit_slots_claimed, memory_order_relaxed);
+    claimed  = claimed < RUNIT_THREAD_SLOTS ? claimed : RUNIT_THREAD_SLOTS;
+    passes   = atomic_load_explicit(&runit_slot_shared.counters.passes, memory_order_relaxed);
+    failures = atomic_load_explicit(&runit_slot_shared.counters.failures, memory_order_relaxed);
+    for (unsigned int i = 0; i < claimed; i++)
+    {
+        passes += atomic_load_explicit(&runit_slots[i].counters.passes, memory_order_relaxed);
+        failures += atomic_load_explicit(&runit_slots[i].counters.failures, memory_order_relaxed);
+    }
+    /* Differences only: the globals may have been reset in the meantime */
+    runit_counter_assert_passes += passes - merged_passes;
+    runit_counter_assert_failures += failures - merged_failures;
+    if (failures != merged_failures)
+    {
+        runit_at_least_one_fail = 1;
+    }
+    merged_passes   = passes;
+    merged_failures = failures;
+    atomic_flag_clear_explicit(&lock, memory_order_release);
+#endif
+}
+
+#if defined(RUNIT_SINK)
+#    if !defined(RUNIT_SINK_CONTEXT)
+#        define RUNIT_SINK_CONTEXT NULL
+#    endif
+void RUNIT_SINK(void* context, const char* record, size_t length);
+static runit_sink_t runit_sink         = RUNIT_SINK;
+static void*        runit_sink_context = RUNIT_SINK_CONTEXT;
+#else
+static runit_sink_t runit_sink         = runit_sink_stdout;
+static void*        runit_sink_context = NULL;
+#endif
+
+#if defined(RUNIT_CLOCK)
+#    if !defined(RUNIT_CLOCK_UNIT)
+#        define RUNIT_CLOCK_UNIT "ticks"
+#    endif
+uint64_t RUNIT_CLOCK(void);
+#elif defined(RUNIT_CLOCK_DWT)
+#    define RUNIT_CLOCK      runit_clock_dwt
+#    define RUNIT_CLOCK_UNIT "cycles"
+#elif RUNIT_HAVE_CLOCK_MONOTONIC
+#    define RUNIT_CLOCK      runit_clock_monotonic
+#    define RUNIT_CLOCK_UNIT "ns"
+#else
+#    define RUNIT_CLOCK      runit_clock_std
+#    define RUNIT_CLOCK_UNIT "ns"
+#endif
+static runit_clock_t runit_clock            = RUNIT_CLOCK;
+static const char*   runit_clock_unit       = RUNIT_CLOCK_UNIT;
+static uint64_t      runit_clock_calibrated = UINT64_MAX; /* Overhead, not measured yet */
+
+static char   runit_ring[RUNIT_SINK_RING_SIZE];
+static size_t runit_ring_head    = 0; /* Next byte to write */
+static size_t runit_ring_tail    = 0; /* Next byte to read */
+static size_t runit_ring_used    = 0;
+static size_t runit_ring_dropped = 0;
+
+void runit_set_sink(const runit_sink_t sink, void* const context)
+{
+    runit_sink         = sink != NULL ? sink : runit_sink_stdout;
+    runit_sink_context = context;
+}
+
+void runit_sink_stdout(void* const context, const char* const record, const size_t length)
+{
+    (void) context;
+    fwrite(record, 1, length, stdout);
+}
+
+#if RUNIT_HAVE_SINK_FD
+void runit_sink_fd(void* const context, const char* const record, const size_t length)
+{
+    const int fd      = (int) (intptr_t) context;
+    size_t    written = 0;
+
+    while (written < length)
+    {
+        const ssize_t result = write(fd, record + written, length - written);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return; /* An error, a full non-blocking pipe (EAGAIN) or no progress: drop the rest */
+        }
+        written += (size_t) result;
+    }
+}
+#endif
+
+void runit_sink_ring(void* const context, const char* const record, const size_t length)
+{
+    size_t first;
+
+    (void) context;
+    if (length > RUNIT_SINK_RING_SIZE - runit_ring_used)
+    {
+        runit_ring_dropped++;
+        return;
+    }
+    /* Copy in up to two chunks, wrapping around the end of the buffer */
+    first = RUNIT_SINK_RING_SIZE - runit_ring_head;
+    first = length < first ? length : first;
+    memcpy(&runit_ring[runit_ring_head], record, first);
+    memcpy(runit_ring, record + first, length - first);
+    runit_ring_head = (runit_ring_head + length) % RUNIT_SINK_RING_SIZE;
+    runit_ring_used += length;
+}
+
+size_t runit_sink_ring_read(char* const dst, const size_t max_length)
+{
+    const size_t length = max_length < runit_ring_used ? max_length : runit_ring_used;
+    size_t       first  = RUNIT_SINK_RING_SIZE - runit_ring_tail;
+
+    first = length < first ? length : first;
+    memcpy(dst, &runit_ring[runit_ring_tail], first);
+    memcpy(dst + first, runit_ring, length - first);
+    runit_ring_tail = (runit_ring_tail + length) % RUNIT_SINK_RING_SIZE;
+    runit_ring_used -= length;
+    return length;
+}
+
+size_t runit_sink_ring_dropped(void)
+{
+    return runit_ring_dropped;
+}
+
+#if RUNIT_HAVE_SITE_SECTION
+/* Defined by the linker around the runit_sites section. Weak, as the section
+ * does not exist in programs without any assertion. */
+extern const runit_site_t __start_runit_sites[] __attribute__((weak));
+extern const runit_site_t __stop_runit_sites[] __attribute__((weak));
+#endif
+
+const runit_site_t* runit_sites_begin(void)
+{
+#if RUNIT_HAVE_SITE_SECTION
+    return __start_runit_sites;
+#else
+    return NULL;
+#endif
+}
+
+const runit_site_t* runit_sites_end(void)
+{
+#if RUNIT_HAVE_SITE_SECTION
+    return __stop_runit_sites;
+#else
+    return NULL;
+#endif
+}
+
+size_t runit_site_count(void)
+{
+    return (size_t) (runit_sites_end() - runit_sites_begin());
+}
+
+#if RUNIT_HAVE_SITE_SECTION
+/* Defined by the linker around the runit_tests section. */
+extern const runit_test_t __start_runit_tests[] __attribute__((weak));
+extern const runit_test_t __stop_runit_tests[] __attribute__((weak));
+#endif
+
+const runit_test_t* runit_tests_begin(void)
+{
+#if RUNIT_HAVE_SITE_SECTION
+    return __start_runit_tests;
+#else
+    return NULL;
+#endif
+}
+
+const runit_test_t* runit_tests_end(void)
+{
+#if RUNIT_HAVE_SITE_SECTION
+    return __stop_runit_tests;
+#else
+    return NULL;
+#endif
+}
+
+size_t runit_test_count(void)
+{
+    return (size_t) (runit_tests_end() - runit_tests_begin());
+}
+
+#if !defined(RUNIT_TOKENIZED)
+/* A source file as printed by runit, see RUNIT_NO_FULL_PATH. */
+static const char* runit_file_name(const char* const path)
+{
+#    if defined(RUNIT_NO_FULL_PATH)
+    const char* file = path;
+    for (const char* c = path; *c != '\0'; c++)
+    {
+        if (*c == '/' || *c == '\\')
+        {
+            file = c + 1;
+        }
+    }
+    return file;
+#    else
+    return path;
+#    endif
+}
+
+/* Name of a signal caught by runit_set_crash_recovery(), "reset" for a reset noticed by runit_resume(). */
+static const char* runit_signal_name(const int signal)
+{
+    if (signal == 0)
+    {
+        return "reset";
+    }
+#    if RUNIT_HAVE_CRASH_RECOVERY
+    switch (signal)
+    {
+        case SIGSEGV:
+            return "SIGSEGV";
+        case SIGBUS:
+            return "SIGBUS";
+        case SIGFPE:
+            return "SIGFPE";
+        case SIGILL:
+            return "SIGILL";
+        default:
+            break;
+    }
+#    else
+    (void) signal;
+#    endif
+    return "?";
+}
+
+static const char* runit_site_file(const runit_site_t* const site)
+{
+    return runit_file_name(site->file);
+}
+
+/* Sends a line formatted by snprintf(), keeping the newline if truncated. */
+static void runit_emit_text(char* const record, const int length)
+{
+    size_t len = (size_t) length;
+
+    if (length < 0)
+    {
+        return;
+    }
+    if (len >= RUNIT_RECORD_MAX)
+    {
+        len              = RUNIT_RECORD_MAX - 1U;
+        record[len - 1U] = '\n';
+    }
+    runit_sink(runit_sink_context, record, len);
+}
+#endif
+
+/* Compact, not yet formatted output of runit: what it is about and values. */
+#define RUNIT_RECORD_ARGS 8U
+
+/* Arguments of the record of the first difference of runit_memeq(), which
+ * tells it apart from the one without the window, or of the worst element of
+ * an array. */
+#define RUNIT_ELEMENT_ARGS 7U
+
+/* Arguments of the record of a failing comparison: type and 64-bit value of
+ * each operand. */
+#define RUNIT_COMPARISON_ARGS 6U
+
+/* Bytes of each memory section shown by a runit_memeq() failure, packed into
+ * 2 arguments of the record. */
+#define RUNIT_MEMEQ_WINDOW 8U
+
+/* Amount of arguments of the record of a benchmark slower than its baseline,
+ * which tells it apart from the one with the results. */
+#define RUNIT_BENCH_REGRESSION_ARGS 3U
+
+/* Registers of a #runit_fault_t, in the record of a HardFault and as its
+ * cause noted for runit_resume(). */
+#define RUNIT_FAULT_ARGS 7U
+typedef struct runit_record
+{
+    const runit_site_t* site;
+    uint32_t            args[RUNIT_RECORD_ARGS];
+    uint8_t             argc;
+} runit_record_t;
+
+static uint32_t runit_saturate_u32(const uint64_t value)
+{
+    return value > UINT32_MAX ? UINT32_MAX : (uint32_t) value;
+}
+
+/* Stores a double into two arguments of a record, low word first. NaNs lose
+ * their sign and payload, for the same text in all modes. */
+static void runit_put_double(uint32_t* const args, const double value)
+{
+    const double canonical = isnan(value) ? (double) NAN : value;
+    uint64_t     bits;
+
+    memcpy(&bits, &canonical, sizeof(bits));
+    args[0] = (uint32_t) bits;
+    args[1] = (uint32_t) (bits >> 32U);
+}
+
+#if defined(RUNIT_TOKENIZED)
+/* Largest tokenized record: marker, token, argument count, arguments. */
+#    define RUNIT_TOKEN_RECORD_MAX (1U + 4U + 1U + RUNIT_RECORD_ARGS * 4U)
+
+static void runit_put_u32(uint8_t* const dst, const uint32_t value)
+{
+    dst[0] = (uint8_t) value;
+    dst[1] = (uint8_t) (value >> 8U);
+    dst[2] = (uint8_t) (value >> 16U);
+    dst[3] = (uint8_t) (value >> 24U);
+}
+
+/* Encodes the record as token and sends it to the sink. */
+static void runit_emit(const runit_record_t* const rec)
+{
+    uint8_t record[RUNIT_TOKEN_RECORD_MAX];
+    size_t  len = 0;
+
+    record[len++] = (uint8_t) RUNIT_TOKEN_MARKER;
+    runit_put_u32(&record[len], (uint32_t) (rec->site - runit_sites_begin()));
+    len += 4U;
+    record[len++] = rec->argc;
+    for (uint8_t i = 0; i < rec->argc; i++)
+    {
+        runit_put_u32(&record[len], rec->args[i]);
+        len += 4U;
+    }
+    runit_sink(runit_sink_context, (const char*) record, len);
+}
+#else
+/* Reads a double stored by runit_put_double(). */
+static double runit_get_double(const uint32_t* const args)
+{
+    const uint64_t bits = (uint64_t) args[0] | (uint64_t) args[1] << 32U;
+    double         value;
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/* Longest text of a value: a pointer, integer or %.17g double. */
+#    define RUNIT_VALUE_TEXT_MAX 32U
+
+/* Writes a value stored by runit_put_value() as text. */
+static void runit_format_value(char* const dst, const uint32_t* const args)
+{
+    const unsigned long long bits = (unsigned long long) args[1] | (unsigned long long) args[2] << 32U;
+
+    switch (args[0])
+    {
+        case RUNIT_VALUE_SIGNED: snprintf(dst, RUNIT_VALUE_TEXT_MAX, "%lld", (long long) bits); break;
+        case RUNIT_VALUE_UNSIGNED: snprintf(dst, RUNIT_VALUE_TEXT_MAX, "%llu", bits); break;
+        case RUNIT_VALUE_FLOAT: snprintf(dst, RUNIT_VALUE_TEXT_MAX, "%.9g", runit_get_double(&args[1])); break;
+        case RUNIT_VALUE_POINTER: snprintf(dst, RUNIT_VALUE_TEXT_MAX, "0x%llx", bits); break;
+        default: snprintf(dst, RUNIT_VALUE_TEXT_MAX, "%.17g", runit_get_double(&args[1])); break;
+    }
+}
+
+/* Writes the bytes of a runit_memeq() window, packed LE into two arguments,
+ * as space-separated hex. */
+static void runit_format_window(char* const dst, const uint32_t* const packed, const uint32_t count)
+{
+    static const char digits[] = "0123456789abcdef";
+    size_t            len      = 0;
+
+    for (uint32_t i = 0; i < count && i < RUNIT_MEMEQ_WINDOW; i++)
+    {
+        const uint32_t byte = (packed[i / 4U] >> (8U * (i % 4U))) & 0xFFU;
+        if (i > 0)
+        {
+            dst[len++] = ' ';
+        }
+        dst[len++] = digits[byte >> 4U];
+        dst[len++] = digits[byte & 0xFU];
+    }
+    dst[len] = '\0';
+}
+
+/* Formats the record as text line and sends it to the sink. */
+static void runit_emit(const runit_record_t* const rec)
+{
+    char                      record[RUNIT_RECORD_MAX];
+    const runit_site_t* const site = rec->site;
+    int                       length;
+
+    if (site->kind == RUNIT_KIND_REPORT)
+    {
+        length = snprintf(record,
+                          sizeof(record),
+                          "REPORT | File: %s:%u | Test case: %s"
+                          " | Passes: %5u | Failures: %5u\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          (unsigned int) rec->args[0],
+                          (unsigned int) rec->args[1]);
+    }
+    else if (site->kind >= RUNIT_KIND_EQ && site->kind <= RUNIT_KIND_LE && rec->argc == RUNIT_COMPARISON_ARGS)
+    {
+        char value_a[RUNIT_VALUE_TEXT_MAX];
+        char value_b[RUNIT_VALUE_TEXT_MAX];
+
+        runit_format_value(value_a, &rec->args[0]);
+        runit_format_value(value_b, &rec->args[3]);
+        length = snprintf(record,
+                          sizeof(record),
+                          "FAIL | File: %s:%u | Test case: %s | Values: %s, %s\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          value_a,
+                          value_b);
+    }
+    else if (site->kind == RUNIT_KIND_SLOWEST)
+    {
+        const runit_test_t* const test = &runit_tests_begin()[rec->args[0]];
+
+        length = snprintf(record,
+                          sizeof(record),
+                          "SLOWEST | File: %s:%u | Test case: %s | Time: %u.%03u ms\n",
+                          runit_file_name(test->file),
+                          test->line,
+                          test->name,
+                          (unsigned int) (rec->args[1] / 1000U),
+                          (unsigned int) (rec->args[1] % 1000U));
+    }
+    else if (site->kind == RUNIT_KIND_CRASH)
+    {
+        const runit_test_t* const test = &runit_tests_begin()[rec->args[0]];
+
+        length = snprintf(record,
+                          sizeof(record),
+                          "CRASH | File: %s:%u | Test case: %s | Signal: %s (%u)\n",
+                          runit_file_name(test->file),
+                          test->line,
+                          test->name,
+                          runit_signal_name((int) rec->args[1]),
+                          (unsigned int) rec->args[1]);
+    }
+    else if (site->kind == RUNIT_KIND_TIMEOUT)
+    {
+        const runit_test_t* const test = &runit_tests_begin()[rec->args[0]];
+
+        length = snprintf(record,
+                          sizeof(record),
+                          "TIMEOUT | File: %s:%u | Test case: %s | Elapsed: %u ms | Limit: %u ms%s\n",
+                          runit_file_name(test->file),
+                          test->line,
+                          test->name,
+                          (unsigned int) rec->args[1],
+                          (unsigned int) rec->args[2],
+                          rec->args[3] ? " for all test cases" : "");
+    }
+    else if (site->kind == RUNIT_KIND_HARDFAULT)
+    {
+        const runit_test_t* const test = rec->args[0] < runit_test_count() ? &runit_tests_begin()[rec->args[0]] : NULL;
+
+        length = snprintf(record,
+                          sizeof(record),
+                          "HARDFAULT | File: %s:%u | Test case: %s | PC: 0x%08X | LR: 0x%08X | xPSR: 0x%08X"
+                          " | CFSR: 0x%08X | HFSR: 0x%08X | MMFAR: 0x%08X | BFAR: 0x%08X\n",
+                          test != NULL ? runit_file_name(test->file) : "?",
+                          test != NULL ? test->line : 0U,
+                          test != NULL ? test->name : "(none)",
+                          (unsigned int) rec->args[1],
+                          (unsigned int) rec->args[2],
+                          (unsigned int) rec->args[3],
+                          (unsigned int) rec->args[4],
+                          (unsigned int) rec->args[5],
+                          (unsigned int) rec->args[6],
+                          (unsigned int) rec->args[7]);
+    }
+    else if (site->kind == RUNIT_KIND_TIMES)
+    {
+        const unsigned long long sum  = (unsigned long long) rec->args[1] | (unsigned long long) rec->args[2] << 32U;
+        const unsigned long long wall = (unsigned long long) rec->args[3] | (unsigned long long) rec->args[4] << 32U;
+
+        length = snprintf(record,
+                          sizeof(record),
+                          "TIMES | Test cases: %u | Sum: %llu.%03u ms | Wall: %llu.%03u ms\n",
+                          (unsigned int) rec->args[0],
+                          sum / 1000U,
+                          (unsigned int) (sum % 1000U),
+                          wall / 1000U,
+                          (unsigned int) (wall % 1000U));
+    }
+    else if (site->kind == RUNIT_KIND_HISTOGRAM)
+    {
+        length = snprintf(record,
+                          sizeof(record),
+                          "HISTOGRAM | <0.1 ms: %u | <1 ms: %u | <10 ms: %u | <100 ms: %u"
+                          " | <1 s: %u | <10 s: %u | >=10 s: %u\n",
+                          (unsigned int) rec->args[0],
+                          (unsigned int) rec->args[1],
+                          (unsigned int) rec->args[2],
+                          (unsigned int) rec->args[3],
+                          (unsigned int) rec->args[4],
+                          (unsigned int) rec->args[5],
+                          (unsigned int) rec->args[6]);
+    }
+    else if (site->kind == RUNIT_KIND_MAX_NS || site->kind == RUNIT_KIND_MAX_CYCLES)
+    {
+        static const char* const statistics[] = {"Min", "Median", "P95"};
+        const char* const        unit         = site->kind == RUNIT_KIND_MAX_NS ? "ns" : "cycles";
+
+        length = snprintf(record,
+                          sizeof(record),
+                          "FAIL | File: %s:%u | Test case: %s | %s of %lu: %lu %s > %lu %s\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          statistics[rec->args[2] <= RUNIT_P95 ? rec->args[2] : RUNIT_P95],
+                          (unsigned long) rec->args[3],
+                          (unsigned long) rec->args[0],
+                          unit,
+                          (unsigned long) rec->args[1],
+                          unit);
+    }
+    else if (site->kind == RUNIT_KIND_ZEROS && rec->argc == 1U)
+    {
+        length = snprintf(record,
+                          sizeof(record),
+                          "FAIL | File: %s:%u | Test case: %s | Non-zero byte at offset %lu\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          (unsigned long) rec->args[0]);
+    }
+    else if (site->kind == RUNIT_KIND_MEMEQ && rec->argc == RUNIT_ELEMENT_ARGS)
+    {
+        char hex_a[3U * RUNIT_MEMEQ_WINDOW];
+        char hex_b[3U * RUNIT_MEMEQ_WINDOW];
+
+        runit_format_window(hex_a, &rec->args[3], rec->args[2]);
+        runit_format_window(hex_b, &rec->args[5], rec->args[2]);
+        length = snprintf(record,
+                          sizeof(record),
+                          "FAIL | File: %s:%u | Test case: %s | First difference at offset %lu"
+                          " | From %lu, a: %s | b: %s\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          (unsigned long) rec->args[0],
+                          (unsigned long) rec->args[1],
+                          hex_a,
+                          hex_b);
+    }
+    else if (site->kind == RUNIT_KIND_FARRAY_DELTA || site->kind == RUNIT_KIND_DARRAY_DELTA)
+    {
+        const int digits = site->kind == RUNIT_KIND_FARRAY_DELTA ? 9 : 17; /* Round trip */
+
+        length = snprintf(record,
+                          sizeof(record),
+                          "FAIL | File: %s:%u | Test case: %s | Worst index %lu | a: %.*g | b: %.*g | Error: %.*g\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          (unsigned long) rec->args[0],
+                          digits,
+                          runit_get_double(&rec->args[1]),
+                          digits,
+                          runit_get_double(&rec->args[3]),
+                          digits,
+                          runit_get_double(&rec->args[5]));
+    }
+    else if (site->kind == RUNIT_KIND_FARRAY_ULP || site->kind == RUNIT_KIND_DARRAY_ULP)
+    {
+        const int digits = site->kind == RUNIT_KIND_FARRAY_ULP ? 9 : 17;
+
+        length = snprintf(record,
+                          sizeof(record),
+                          "FAIL | File: %s:%u | Test case: %s | Worst index %lu | a: %.*g | b: %.*g | ULP distance: %llu\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          (unsigned long) rec->args[0],
+                          digits,
+                          runit_get_double(&rec->args[1]),
+                          digits,
+                          runit_get_double(&rec->args[3]),
+                          (unsigned long long) rec->args[5] | (unsigned long long) rec->args[6] << 32U);
+    }
+    else if (site->kind == RUNIT_KIND_FULP || site->kind == RUNIT_KIND_DULP)
+    {
+        length = snprintf(record,
+                          sizeof(record),
+                          "FAIL | File: %s:%u | Test case: %s | ULP distance: %llu > %llu\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          (unsigned long long) rec->args[0] | (unsigned long long) rec->args[1] << 32U,
+                          (unsigned long long) rec->args[2] | (unsigned long long) rec->args[3] << 32U);
+    }
+    else if (site->kind == RUNIT_KIND_ARRAY_EQ)
+    {
+        const int digits = (int) rec->args[1] * 2;
+
+        length = snprintf(record,
+                          sizeof(record),
+                          "FAIL | File: %s:%u | Test case: %s | First difference at index %lu | a: 0x%0*llx | b: 0x%0*llx\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          (unsigned long) rec->args[0],
+                          digits,
+                          (unsigned long long) rec->args[2] | (unsigned long long) rec->args[3] << 32U,
+                          digits,
+                          (unsigned long long) rec->args[4] | (unsigned long long) rec->args[5] << 32U);
+    }
+    else if (site->kind == RUNIT_KIND_BENCH && rec->argc == RUNIT_BENCH_REGRESSION_ARGS)
+    {
+        length = snprintf(record,
+                          sizeof(record),
+                          "FAIL | File: %s:%u | Test case: %s | Regression: %s"
+                          " | Median: %lu.%02lu -> %lu.%02lu | z: %lu.%02lu\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          site->expression,
+                          (unsigned long) (rec->args[0] / 100U),
+                          (unsigned long) (rec->args[0] % 100U),
+                          (unsigned long) (rec->args[1] / 100U),
+                          (unsigned long) (rec->args[1] % 100U),
+                          (unsigned long) (rec->args[2] / 100U),
+                          (unsigned long) (rec->args[2] % 100U));
+    }
+    else if (site->kind == RUNIT_KIND_BENCH)
+    {
+        length = snprintf(record,
+                          sizeof(record),
+                          "BENCH | File: %s:%u | Test case: %s | Name: %s | Samples: %lu x %lu"
+                          " | Min: %lu.%02lu | Median: %lu.%02lu | Mean: %lu.%02lu | P99: %lu.%02lu"
+                          " | Stddev: %lu.%02lu | Unit: %s\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function,
+                          site->expression,
+                          (unsigned long) rec->args[0],
+                          (unsigned long) rec->args[1],
+                          (unsigned long) (rec->args[2] / 100U),
+                          (unsigned long) (rec->args[2] % 100U),
+                          (unsigned long) (rec->args[3] / 100U),
+                          (unsigned long) (rec->args[3] % 100U),
+                          (unsigned long) (rec->args[4] / 100U),
+                          (unsigned long) (rec->args[4] % 100U),
+                          (unsigned long) (rec->args[5] / 100U),
+                          (unsigned long) (rec->args[5] % 100U),
+                          (unsigned long) (rec->args[6] / 100U),
+                          (unsigned long) (rec->args[6] % 100U),
+                          runit_clock_unit);
+    }
+    else
+    {
+        length = snprintf(record,
+                          sizeof(record),
+                          "FAIL | File: %s:%u | Test case: %s\n",
+                          runit_site_file(site),
+                          site->line,
+                          site->function);
+    }
+    runit_emit_text(record, length);
+}
+#endif
+
+/*
+ * Deferred output: a single-producer/single-consumer queue of records.
+ * The producer (the test code) only writes runit_queue_head, the consumer
+ * (runit_flush(), e.g. from an ISR or another thread) only writes
+ * runit_queue_tail. Both are free-running counters, their difference is the
+ * amount of queued records.
+ */
+#if !defined(__STDC_NO_ATOMICS__)
+#    include <stdatomic.h>
+typedef atomic_uint runit_index_t;
+#    define RUNIT_LOAD_ACQUIRE(index)         atomic_load_explicit(&(index), memory_order_acquire)
+#    define RUNIT_LOAD_RELAXED(index)         atomic_load_explicit(&(index), memory_order_relaxed)
+#    define RUNIT_STORE_RELEASE(index, value) atomic_store_explicit(&(index), (value), memory_order_release)
+#else
+/* Without C11 atomics the queue is only safe on single-core targets. */
+typedef volatile unsigned int runit_index_t;
+#    define RUNIT_LOAD_ACQUIRE(index)         (index)
+#    define RUNIT_LOAD_RELAXED(index)         (index)
+#    define RUNIT_STORE_RELEASE(index, value) ((index) = (value))
+#endif
+
+#if (RUNIT_DEFERRED_CAPACITY & (RUNIT_DEFERRED_CAPACITY - 1U)) != 0U
+#    error "RUNIT_DEFERRED_CAPACITY must be a power of 2"
+#endif
+
+static runit_record_t runit_queue[RUNIT_DEFERRED_CAPACITY];
+static runit_index_t  runit_queue_head      = 0;
+static runit_index_t  runit_queue_tail      = 0;
+static runit_index_t  runit_queue_overflows = 0;
+static char           runit_deferred        = 0;
+
+void runit_set_deferred(const int enabled)
+{
+    if (!enabled)
+    {
+        runit_flush();
+    }
+    runit_deferred = (char) (enabled != 0);
+}
+
+size_t runit_flush(void)
+{
+    const unsigned int head  = RUNIT_LOAD_ACQUIRE(runit_queue_head);
+    unsigned int       tail  = RUNIT_LOAD_RELAXED(runit_queue_tail);
+    size_t             count = 0;
+
+    while (tail != head)
+    {
+        runit_emit(&runit_queue[tail % RUNIT_DEFERRED_CAPACITY]);
+        tail++;
+        count++;
+        RUNIT_STORE_RELEASE(runit_queue_tail, tail);
+    }
+    return count;
+}
+
+size_t runit_deferred_overflows(void)
+{
+    return RUNIT_LOAD_RELAXED(runit_queue_overflows);
+}
+
+/* Sends the record to the sink now or queues it for runit_flush(). */
+static void runit_output(const runit_record_t* const rec)
+{
+    unsigned int head;
+
+    if (!runit_deferred)
+    {
+        runit_emit(rec);
+        return;
+    }
+    head = RUNIT_LOAD_RELAXED(runit_queue_head);
+    if (head - RUNIT_LOAD_ACQUIRE(runit_queue_tail) >= RUNIT_DEFERRED_CAPACITY)
+    {
+        RUNIT_STORE_RELEASE(runit_queue_overflows, RUNIT_LOAD_RELAXED(runit_queue_overflows) + 1U);
+        return;
+    }
+    runit_queue[head % RUNIT_DEFERRED_CAPACITY] = *rec;
+    RUNIT_STORE_RELEASE(runit_queue_head, head + 1U);
+}
+
+static void runit_count_failure(void)
+{
+#if defined(RUNIT_THREAD_SAFE)
+    runit_count(1);
+#else
+    runit_counter_assert_failures++;
+    runit_at_least_one_fail = 1;
+#endif
+}
+
+/* Sends the record of a failure and counts it. */
+static RUNIT_COLD void runit_fail_with(const runit_record_t* const record)
+{
+    runit_output(record);
+    runit_count_failure();
+}
+
+RUNIT_COLD int runit_expect_record_(void)
+{
+    if (runit_expect_recorded < RUNIT_EXPECT_MAX)
+    {
+        runit_expect_recorded++;
+        return 1;
+    }
+    runit_count_failure();
+    return 0;
+}
+
+RUNIT_COLD void runit_report_failure(const runit_site_t* const site)
+{
+    const runit_record_t record = {site, {0}, 0};
+
+    runit_fail_with(&record);
+}
+
+RUNIT_COLD void runit_report_at(const runit_site_t* const site)
+{
+    runit_record_t record = {site, {0}, 2};
+
+    runit_expect_recorded = 0;
+    runit_counters_merge();
+    record.args[0] = runit_counter_assert_passes;
+    record.args[1] = runit_counter_assert_failures;
+    runit_output(&record);
+}
+
+/* Durations of the test cases of the last run, see runit_report_times(). */
+static uint32_t runit_times[RUNIT_TIMES_CAPACITY]; /* Microseconds, by index */
+static uint32_t runit_times_histogram[RUNIT_HISTOGRAM_BUCKETS];
+static uint32_t runit_times_count = 0;
+static uint64_t runit_times_sum   = 0; /* Microseconds */
+static uint64_t runit_times_wall  = 0; /* Microseconds */
+
+static void runit_times_reset(void)
+{
+    memset(runit_times, 0, sizeof(runit_times));
+    memset(runit_times_histogram, 0, sizeof(runit_times_histogram));
+    runit_times_count = 0;
+    runit_times_sum   = 0;
+    runit_times_wall  = 0;
+}
+
+static void runit_times_add(const size_t index, const uint32_t microseconds)
+{
+    uint32_t bucket = 0;
+
+    for (uint32_t limit = 100U; bucket + 1U < RUNIT_HISTOGRAM_BUCKETS && microseconds >= limit; limit *= 10U)
+    {
+        bucket++;
+    }
+    if (index < RUNIT_TIMES_CAPACITY)
+    {
+        runit_times[index] = microseconds;
+    }
+    runit_times_histogram[bucket]++;
+    runit_times_count++;
+    runit_times_sum += microseconds;
+}
+
+/* Timeouts of runit_set_timeout(); the deadline of the whole run in ns of runit_clock_ns(), 0 without. */
+static uint32_t        runit_timeout_test_ms  = 0;
+static uint32_t        runit_timeout_total_ms = 0;
+static uint64_t        runit_timeout_started  = 0;
+static uint64_t        runit_timeout_deadline = 0;
+static char            runit_timeout_expired  = 0; /* The whole run, no more test cases */
+static volatile size_t runit_current          = RUNIT_NO_TEST;
+#if RUNIT_HAVE_PARALLEL
+static atomic_uint* runit_timeout_reported = NULL; /* Shared by the workers of runit_run_parallel() */
+#endif
+
+/* Whether to report the end of the whole run: only the first worker does, the others just stop. */
+static int runit_timeout_whole_first(void)
+{
+#if RUNIT_HAVE_PARALLEL
+    return runit_timeout_reported == NULL
+           || atomic_exchange_explicit(runit_timeout_reported, 1U, memory_order_relaxed) == 0U;
+#else
+    return 1;
+#endif
+}
+
+static RUNIT_COLD void runit_timeout_fail(const size_t   index,
+                                          const uint32_t elapsed_ms,
+                                          const uint32_t limit_ms,
+                                          const uint32_t whole)
+{
+    RUNIT_SITE_NAMED_(timeout_site, RUNIT_KIND_TIMEOUT, "");
+    const runit_record_t record = {&timeout_site, {(uint32_t) index, elapsed_ms, limit_ms, whole}, 4};
+
+    runit_fail_with(&record);
+}
+
+void runit_fail_timeout(const size_t index, const uint32_t elapsed_ms, const uint32_t limit_ms)
+{
+    runit_timeout_fail(index, elapsed_ms, limit_ms, 0U);
+}
+
+size_t runit_current_test(void)
+{
+    return runit_current;
+}
+
+/* At the start of a run, also before forking the workers: they share the deadline. */
+static void runit_timeout_start(void)
+{
+    runit_timeout_started  = runit_clock_ns();
+    runit_timeout_deadline = 0;
+    runit_timeout_expired  = 0;
+    if (runit_timeout_total_ms > 0)
+    {
+        runit_timeout_deadline = runit_timeout_started + (uint64_t) runit_timeout_total_ms * 1000000U;
+    }
+}
+
+/* Whether the whole run is over, reporting it on the test case that will not run. */
+static int runit_timeout_passed(const size_t index)
+{
+    if (!runit_timeout_expired && runit_timeout_deadline != 0 && runit_clock_ns() >= runit_timeout_deadline)
+    {
+        runit_timeout_expired = 1;
+        if (runit_timeout_whole_first())
+        {
+            runit_timeout_fail(index,
+                               runit_saturate_u32((runit_clock_ns() - runit_timeout_started) / 1000000U),
+                               runit_timeout_total_ms,
+                               1U);
+        }
+    }
+    return runit_timeout_expired;
+}
+
+static RUNIT_COLD void runit_crash_fail(const size_t index, const uint32_t signal)
+{
+    RUNIT_SITE_NAMED_(crash_site, RUNIT_KIND_CRASH, "");
+    const runit_record_t record = {&crash_site, {(uint32_t) index, signal}, 2};
+
+    runit_fail_with(&record);
+}
+
+/* Fault registers as the arguments of the record, after the index of the test case. */
+static RUNIT_COLD void runit_fault_fail(const size_t index, const uint32_t* const registers)
+{
+    RUNIT_SITE_NAMED_(fault_site, RUNIT_KIND_HARDFAULT, "");
+    runit_record_t record = {&fault_site, {(uint32_t) index}, 1U + RUNIT_FAULT_ARGS};
+
+    for (size_t i = 0; i < RUNIT_FAULT_ARGS; i++)
+    {
+        record.args[1U + i] = registers[i];
+    }
+    runit_fail_with(&record);
+}
+
+/* State of runit_resume(), NULL without; the magic is cleared when a run is complete. */
+#define RUNIT_PERSISTENT_MAGIC 0x52554E49U /* "RUNI" */
+static runit_persistent_t* runit_persistent = NULL;
+
+/* CRC-32 (IEEE 802.3), bit by bit: small, and only run twice per test case. */
+static uint32_t runit_crc32(const void* const data, const size_t size)
+{
+    const uint8_t* const bytes = data;
+    uint32_t             crc   = 0xFFFFFFFFU;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= bytes[i];
+        for (unsigned int bit = 0; bit < 8U; bit++)
+        {
+            crc = (crc >> 1U) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+static void runit_persistent_seal(runit_persistent_t* const state)
+{
+    state->crc = runit_crc32(state, offsetof(runit_persistent_t, crc));
+}
+
+/* Before (running) and after each test case: where to go on after a reset. */
+static void runit_persistent_save(const size_t test, const uint32_t running)
+{
+    runit_persistent_t* const state = runit_persistent;
+
+    if (state != NULL)
+    {
+        runit_counters_merge();
+        state->magic    = RUNIT_PERSISTENT_MAGIC;
+        state->test     = (uint32_t) test;
+        state->running  = running;
+        state->passes   = runit_counter_assert_passes;
+        state->failures = runit_counter_assert_failures;
+        state->cause    = 0;
+        state->argc     = 0;
+        runit_persistent_seal(state);
+    }
+}
+
+void runit_persist_cause(const runit_kind_t kind, const uint32_t* const args, const size_t argc)
+{
+    runit_persistent_t* const state = runit_persistent;
+
+    if (state != NULL && state->running && argc <= RUNIT_CAUSE_ARGS)
+    {
+        state->cause = (uint32_t) kind;
+        state->argc  = (uint32_t) argc;
+        for (size_t i = 0; i < argc; i++)
+        {
+            state->args[i] = args[i];
+        }
+        runit_persistent_seal(state);
+    }
+}
+
+int runit_fail_fault(const runit_fault_t* const fault)
+{
+    const uint32_t registers[RUNIT_FAULT_ARGS] = {
+        fault->pc, fault->lr, fault->xpsr, fault->cfsr, fault->hfsr, fault->mmfar, fault->bfar};
+
+    if (runit_persistent != NULL && runit_persistent->running)
+    {
+        runit_persist_cause(RUNIT_KIND_HARDFAULT, registers, RUNIT_FAULT_ARGS);
+        return 1;
+    }
+    runit_fault_fail(runit_current, registers);
+    runit_flush(); /* Nothing runs after a halt */
+    return 0;
+}
+
+size_t runit_resume(runit_persistent_t* const state)
+{
+    size_t first = 0;
+
+    runit_persistent = state;
+    if (state == NULL)
+    {
+        return 0;
+    }
+    if (state->magic == RUNIT_PERSISTENT_MAGIC && state->crc == runit_crc32(state, offsetof(runit_persistent_t, crc))
+        && state->test < runit_test_count())
+    {
+        runit_counters_merge();
+        runit_counter_assert_passes   = state->passes;
+        runit_counter_assert_failures = state->failures;
+        runit_at_least_one_fail       = (char) (state->failures > 0);
+        first                         = state->test;
+        if (state->running)
+        {
+            /* The reset came from that test case: report it with its cause, if noted */
+            if (state->cause == RUNIT_KIND_TIMEOUT && state->argc == 3U)
+            {
+                runit_timeout_fail(first, state->args[0], state->args[1], state->args[2]);
+                first = state->args[2] ? runit_test_count() : first + 1U; /* The whole run is over */
+            }
+            else if (state->cause == RUNIT_KIND_HARDFAULT && state->argc == RUNIT_FAULT_ARGS)
+            {
+                runit_fault_fail(first, state->args);
+                first++;
+            }
+            else
+            {
+                runit_crash_fail(first, state->cause == RUNIT_KIND_CRASH && state->argc == 1U ? state->args[0] : 0U);
+                first++;
+            }
+        }
+    }
+    runit_persistent_save(first, 0);
+    return first;
+}
+
+#if RUNIT_HAVE_CRASH_RECOVERY
+/* Signals caught by runit_set_crash_recovery(), with the handlers they had before. */
+static const int        runit_crash_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL};
+static struct sigaction runit_crash_previous[sizeof(runit_crash_signals) / sizeof(runit_crash_signals[0])];
+static char             runit_crash_enabled = 0;
+static struct sigaction runit_alarm_previous; /* SIGALRM of the timeouts */
+static char             runit_alarm_caught  = 0;
+static char             runit_signal_stack[RUNIT_CRASH_STACK_SIZE];
+static char             runit_signal_stack_set = 0;
+
+/* Where the handler jumps back to, only while a test case of this thread runs: per thread even without
+ * RUNIT_THREAD_SAFE, so that a crash in another thread never jumps onto the stack of the runner. */
+static _Thread_local sigjmp_buf            runit_crash_jump;
+static _Thread_local volatile sig_atomic_t runit_crash_armed  = 0;
+static _Thread_local volatile sig_atomic_t runit_crash_signal = 0;
+
+static void runit_crash_handler(const int signal)
+{
+    if (runit_crash_armed)
+    {
+        runit_crash_armed  = 0;
+        runit_crash_signal = signal;
+        siglongjmp(runit_crash_jump, 1);
+    }
+    if (signal == SIGALRM)
+    {
+        return; /* A late alarm is dropped */
+    }
+    /* Not in a test case of this thread: the crash goes to the previous handler, the handler of runit stays
+     * installed for the other test cases of the run */
+    for (size_t i = 0; i < sizeof(runit_crash_signals) / sizeof(runit_crash_signals[0]); i++)
+    {
+        if (runit_crash_signals[i] == signal)
+        {
+            sigaction(signal, &runit_crash_previous[i], NULL);
+        }
+    }
+    raise(signal);
+    _exit(128 + signal); /* The previous handler returned, the faulting instruction would run again */
+}
+
+/* Handles the signal on the static stack, returns 0 on success. */
+static int runit_signal_catch(const int signal, struct sigaction* const previous)
+{
+    struct sigaction action;
+
+    if (!runit_signal_stack_set)
+    {
+        stack_t stack;
+
+        stack.ss_sp    = runit_signal_stack;
+        stack.ss_size  = sizeof(runit_signal_stack);
+        stack.ss_flags = 0;
+        if (sigaltstack(&stack, NULL) != 0)
+        {
+            return -1;
+        }
+        runit_signal_stack_set = 1;
+    }
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = runit_crash_handler;
+    action.sa_flags   = SA_ONSTACK | SA_NODEFER; /* Nothing blocked, nothing to restore after the jump */
+    sigemptyset(&action.sa_mask);
+    return sigaction(signal, &action, previous);
+}
+
+int runit_set_crash_recovery(const int enable)
+{
+    const size_t signals = sizeof(runit_crash_signals) / sizeof(runit_crash_signals[0]);
+
+    if (enable && !runit_crash_enabled)
+    {
+        for (size_t i = 0; i < signals; i++)
+        {
+            if (runit_signal_catch(runit_crash_signals[i], &runit_crash_previous[i]) != 0)
+            {
+                while (i-- > 0)
+                {
+                    sigaction(runit_crash_signals[i], &runit_crash_previous[i], NULL);
+                }
+                return -1;
+            }
+        }
+    }
+    else if (!enable && runit_crash_enabled)
+    {
+        for (size_t i = 0; i < signals; i++)
+        {
+            sigaction(runit_crash_signals[i], &runit_crash_previous[i], NULL);
+        }
+    }
+    runit_crash_enabled = (char) (enable != 0);
+    return 0;
+}
+
+int runit_set_timeout(const uint32_t test_ms, const uint32_t total_ms)
+{
+    const int enable = test_ms > 0 || total_ms > 0;
+
+    if (enable && !runit_alarm_caught)
+    {
+        if (runit_signal_catch(SIGALRM, &runit_alarm_previous) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (!enable && runit_alarm_caught)
+    {
+        sigaction(SIGALRM, &runit_alarm_previous, NULL);
+    }
+    runit_alarm_caught     = (char) enable;
+    runit_timeout_test_ms  = test_ms;
+    runit_timeout_total_ms = total_ms;
+    return 0;
+}
+
+/* Sends SIGALRM to the process after that many milliseconds, 0 cancels it. */
+static void runit_alarm(const uint32_t milliseconds)
+{
+    struct itimerval timer;
+
+    memset(&timer, 0, sizeof(timer));
+    timer.it_value.tv_sec  = (time_t) (milliseconds / 1000U);
+    timer.it_value.tv_usec = (suseconds_t) (milliseconds % 1000U * 1000U);
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+/* Runs the test case, returns the signal that stopped it or 0. */
+static int runit_run_guarded(const runit_test_t* const test, const uint32_t limit_ms)
+{
+    if (sigsetjmp(runit_crash_jump, 0) == 0)
+    {
+        runit_crash_armed = 1;
+        if (limit_ms > 0)
+        {
+            runit_alarm(limit_ms);
+        }
+        test->function();
+        runit_crash_armed = 0;
+        if (limit_ms > 0)
+        {
+            runit_alarm(0);
+        }
+        return 0;
+    }
+    runit_alarm(0);
+    return runit_crash_signal;
+}
+
+/* Time left for a test case starting now, 0 without limit; whole when the end of the run comes first. */
+static uint32_t runit_timeout_limit(const uint64_t now, uint32_t* const whole)
+{
+    uint32_t limit = runit_timeout_test_ms;
+
+    *whole = 0;
+    if (runit_timeout_deadline != 0)
+    {
+        const uint64_t left = runit_timeout_deadline > now ? (runit_timeout_deadline - now + 999999U) / 1000000U : 1U;
+        if (limit == 0 || left < limit)
+        {
+            limit  = runit_saturate_u32(left);
+            *whole = 1;
+        }
+    }
+    return limit;
+}
+
+/* Runs the test case, reporting a crash or timeout as a failure. */
+static void runit_run_recovering(const runit_test_t* const test, const size_t index, const uint64_t start)
+{
+    uint32_t       whole;
+    const uint32_t limit  = runit_timeout_limit(start, &whole);
+    const int      signal = runit_run_guarded(test, limit);
+
+    if (signal == SIGALRM)
+    {
+        const uint64_t since = whole ? runit_timeout_started : start;
+        runit_timeout_expired |= (char) whole;
+        if (!whole || runit_timeout_whole_first())
+        {
+            runit_timeout_fail(index,
+                               runit_saturate_u32((runit_clock_ns() - since) / 1000000U),
+                               whole ? runit_timeout_total_ms : limit,
+                               whole);
+        }
+    }
+    else if (signal != 0)
+    {
+        runit_crash_fail(index, (uint32_t) signal);
+    }
+}
+#else
+int runit_set_crash_recovery(const int enable)
+{
+    return enable ? -1 : 0;
+}
+
+int runit_set_timeout(const uint32_t test_ms, const uint32_t total_ms)
+{
+    return test_ms > 0 || total_ms > 0 ? -1 : 0;
+}
+#endif
+
+/* Runs one test case, returns its duration in microseconds. */
+static uint32_t runit_run_test(const runit_test_t* const test)
+{
+    const uint64_t start = runit_clock_ns();
+    const size_t   index = (size_t) (test - runit_tests_begin());
+
+    runit_expect_recorded = 0;
+    runit_current         = index;
+    runit_persistent_save(index, 1U);
+#if RUNIT_HAVE_CRASH_RECOVERY
+    if (runit_crash_enabled || runit_alarm_caught)
+    {
+        runit_run_recovering(test, index, start);
+    }
+    else
+#endif
+    {
+        test->function();
+    }
+    runit_current = RUNIT_NO_TEST;
+    runit_persistent_save(index + 1U, 0);
+    return runit_saturate_u32((runit_clock_ns() - start) / 1000U);
+}
+
+size_t runit_run_from(const size_t first)
+{
+    const runit_test_t* const tests = runit_tests_begin();
+    const size_t              count = runit_test_count();
+    const uint64_t            start = runit_clock_ns();
+
+    runit_times_reset();
+    runit_timeout_start();
+    for (size_t i = first; i < count && !runit_timeout_passed(i); i++)
+    {
+        if (runit_in_shard(i))
+        {
+            runit_times_add(i, runit_run_test(&tests[i]));
+        }
+    }
+    runit_times_wall = (runit_clock_ns() - start) / 1000U;
+    runit_counters_merge();
+    if (runit_persistent != NULL)
+    {
+        runit_persistent->magic = 0; /* Complete: the next reset starts over */
+    }
+    return runit_times_count;
+}
+
+size_t runit_run_all(void)
+{
+    return runit_run_from(0);
+}
+
+uint32_t runit_test_time(const size_t index)
+{
+    return index < RUNIT_TIMES_CAPACITY ? runit_times[index] : 0U;
+}
+
+void runit_report_times(void)
+{
+    RUNIT_SITE_NAMED_(slowest_site, RUNIT_KIND_SLOWEST, "");
+    RUNIT_SITE_NAMED_(times_site, RUNIT_KIND_TIMES, "");
+    RUNIT_SITE_NAMED_(histogram_site, RUNIT_KIND_HISTOGRAM, "");
+    const size_t   kept = runit_test_count() < RUNIT_TIMES_CAPACITY ? runit_test_count() : RUNIT_TIMES_CAPACITY;
+    size_t         slowest[RUNIT_SLOWEST];
+    size_t         shown  = 0;
+    runit_record_t record = {&times_site, {0}, 5};
+
+    /* Insertion into the sorted list of the slowest ones so far */
+    for (size_t i = 0; i < kept; i++)
+    {
+        size_t at = shown;
+        while (at > 0 && runit_times[slowest[at - 1U]] < runit_times[i])
+        {
+            if (at < RUNIT_SLOWEST)
+            {
+                slowest[at] = slowest[at - 1U];
+            }
+            at--;
+        }
+        if (at < RUNIT_SLOWEST && runit_times[i] > 0)
+        {
+            slowest[at] = i;
+            shown += shown < RUNIT_SLOWEST ? 1U : 0U;
+        }
+    }
+    for (size_t i = 0; i < shown; i++)
+    {
+        const runit_record_t line = {&slowest_site, {(uint32_t) slowest[i], runit_times[slowest[i]]}, 2};
+        runit_output(&line);
+    }
+    record.args[0] = runit_times_count;
+    record.args[1] = (uint32_t) runit_times_sum;
+    record.args[2] = (uint32_t) (runit_times_sum >> 32U);
+    record.args[3] = (uint32_t) runit_times_wall;
+    record.args[4] = (uint32_t) (runit_times_wall >> 32U);
+    runit_output(&record);
+    record.site = &histogram_site;
+    record.argc = RUNIT_HISTOGRAM_BUCKETS;
+    memcpy(record.args, runit_times_histogram, sizeof(runit_times_histogram));
+    runit_output(&record);
+}
+
+/* Shard of runit_set_shard(); when balanced, where each test case went. */
+#define RUNIT_SHARD_IN      1U
+#define RUNIT_SHARD_OUT     2U
+#define RUNIT_SHARD_UNKNOWN UINT32_MAX
+static size_t        runit_shard_index    = 0;
+static size_t        runit_shard_count    = 1;
+static char          runit_shard_balanced = 0;
+static size_t        runit_shard_unplaced = 0; /* Beyond the plan when balanced */
+static unsigned char runit_shard_plan[RUNIT_TIMES_CAPACITY]; /* 0 until placed */
+static uint32_t      runit_shard_weights[RUNIT_TIMES_CAPACITY];
+static uint64_t      runit_shard_loads[RUNIT_SHARD_MAX];
+
+/* Durations from the file of runit_save_times(), the average of them for the missing test cases. */
+static void runit_shard_weigh(const char* const path, const runit_test_t* const tests, const size_t kept)
+{
+    FILE* const   file = fopen(path, "r");
+    char          name[256];
+    unsigned long microseconds;
+    uint64_t      sum   = 0;
+    size_t        known = 0;
+
+    for (size_t i = 0; i < kept; i++)
+    {
+        runit_shard_weights[i] = RUNIT_SHARD_UNKNOWN;
+    }
+    while (file != NULL && fscanf(file, "%255s %lu", name, &microseconds) == 2)
+    {
+        for (size_t i = 0; i < kept; i++)
+        {
+            if (strcmp(tests[i].name, name) == 0)
+            {
+                const uint32_t weight  = runit_saturate_u32(microseconds);
+                runit_shard_weights[i] = weight < RUNIT_SHARD_UNKNOWN ? weight : RUNIT_SHARD_UNKNOWN - 1U;
+            }
+        }
+    }
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    for (size_t i = 0; i < kept; i++)
+    {
+        if (runit_shard_weights[i] != RUNIT_SHARD_UNKNOWN)
+        {
+            sum += runit_shard_weights[i];
+            known++;
+        }
+    }
+    for (size_t i = 0; i < kept; i++)
+    {
+        if (runit_shard_weights[i] == RUNIT_SHARD_UNKNOWN)
+        {
+            runit_shard_weights[i] = known > 0 ? (uint32_t) (sum / known) : 1U;
+        }
+    }
+}
+
+int runit_set_shard(const size_t index, const size_t count, const char* const times)
+{
+    const size_t kept = runit_test_count() < RUNIT_TIMES_CAPACITY ? runit_test_count() : RUNIT_TIMES_CAPACITY;
+
+    if (index >= count)
+    {
+        return -1;
+    }
+    runit_shard_index    = index;
+    runit_shard_count    = count;
+    runit_shard_balanced = (char) (times != NULL && count > 1U && count <= RUNIT_SHARD_MAX);
+    runit_shard_unplaced = 0;
+    if (!runit_shard_balanced)
+    {
+        return 0;
+    }
+    runit_shard_unplaced = runit_test_count() - kept;
+    runit_shard_weigh(times, runit_tests_begin(), kept);
+    memset(runit_shard_plan, 0, sizeof(runit_shard_plan));
+    memset(runit_shard_loads, 0, sizeof(runit_shard_loads));
+    /* Longest first into the least loaded shard; ties by position, so every shard gets the same plan */
+    for (size_t placed = 0; placed < kept; placed++)
+    {
+        size_t longest  = kept;
+        size_t lightest = 0;
+        for (size_t i = 0; i < kept; i++)
+        {
+            if (runit_shard_plan[i] == 0 && (longest == kept || runit_shard_weights[i] > runit_shard_weights[longest]))
+            {
+                longest = i;
+            }
+        }
+        for (size_t shard = 1; shard < count; shard++)
+        {
+            if (runit_shard_loads[shard] < runit_shard_loads[lightest])
+            {
+                lightest = shard;
+            }
+        }
+        runit_shard_loads[lightest] += runit_shard_weights[longest];
+        runit_shard_plan[longest] = lightest == index ? RUNIT_SHARD_IN : RUNIT_SHARD_OUT;
+    }
+    return 0;
+}
+
+size_t runit_shard_unplanned(void)
+{
+    return runit_shard_unplaced;
+}
+
+int runit_in_shard(const size_t index)
+{
+    if (runit_shard_balanced && index < RUNIT_TIMES_CAPACITY)
+    {
+        return runit_shard_plan[index] == RUNIT_SHARD_IN;
+    }
+    return index % runit_shard_count == runit_shard_index;
+}
+
+int runit_save_times(const char* const path)
+{
+    const runit_test_t* const tests = runit_tests_begin();
+    const size_t kept  = runit_test_count() < RUNIT_TIMES_CAPACITY ? runit_test_count() : RUNIT_TIMES_CAPACITY;
+    FILE* const  file  = fopen(path, "w");
+
+    if (file == NULL)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < kept; i++)
+    {
+        if (runit_in_shard(i))
+        {
+            fprintf(file, "%s %lu\n", tests[i].name, (unsigned long) runit_times[i]);
+        }
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+/* Bytes checked per iteration of the vector loop, 4 registers at once. */
+#if defined(__AVX2__)
+#    define RUNIT_SCAN_BLOCK (4U * sizeof(__m256i))
+#elif defined(__SSE2__)
+#    define RUNIT_SCAN_BLOCK (4U * sizeof(__m128i))
+#elif defined(__ARM_NEON)
+#    define RUNIT_SCAN_BLOCK (4U * sizeof(uint8x16_t))
+#endif
+
+#if defined(RUNIT_SCAN_BLOCK)
+/* Non-zero if any byte of the block is not zero. */
+static int runit_block_nonzero(const uint8_t* const block)
+{
+#    if defined(__AVX2__)
+    const __m256i any = _mm256_or_si256(
+        _mm256_or_si256(_mm256_loadu_si256((const __m256i*) block), _mm256_loadu_si256((const __m256i*) block + 1)),
+        _mm256_or_si256(_mm256_loadu_si256((const __m256i*) block + 2), _mm256_loadu_si256((const __m256i*) block + 3)));
+    return !_mm256_testz_si256(any, any);
+#    elif defined(__SSE2__)
+    const __m128i any = _mm_or_si128(
+        _mm_or_si128(_mm_loadu_si128((const __m128i*) block), _mm_loadu_si128((const __m128i*) block + 1)),
+        _mm_or_si128(_mm_loadu_si128((const __m128i*) block + 2), _mm_loadu_si128((const __m128i*) block + 3)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xFFFF;
+#    else
+    const uint64x2_t any = vreinterpretq_u64_u8(
+        vorrq_u8(vorrq_u8(vld1q_u8(block), vld1q_u8(block + 16)), vorrq_u8(vld1q_u8(block + 32), vld1q_u8(block + 48))));
+    return (vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)) != 0U;
+#    endif
+}
+
+/* Non-zero if any byte of the two blocks differs. */
+static int runit_blocks_differ(const uint8_t* const a, const uint8_t* const b)
+{
+#    if defined(__AVX2__)
+    const __m256i* const va  = (const __m256i*) a;
+    const __m256i* const vb  = (const __m256i*) b;
+    const __m256i        any = _mm256_or_si256(
+        _mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256(va), _mm256_loadu_si256(vb)),
+                        _mm256_xor_si256(_mm256_loadu_si256(va + 1), _mm256_loadu_si256(vb + 1))),
+        _mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256(va + 2), _mm256_loadu_si256(vb + 2)),
+                        _mm256_xor_si256(_mm256_loadu_si256(va + 3), _mm256_loadu_si256(vb + 3))));
+    return !_mm256_testz_si256(any, any);
+#    elif defined(__SSE2__)
+    const __m128i* const va  = (const __m128i*) a;
+    const __m128i* const vb  = (const __m128i*) b;
+    const __m128i        all = _mm_and_si128(
+        _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(va), _mm_loadu_si128(vb)),
+                      _mm_cmpeq_epi8(_mm_loadu_si128(va + 1), _mm_loadu_si128(vb + 1))),
+        _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(va + 2), _mm_loadu_si128(vb + 2)),
+                      _mm_cmpeq_epi8(_mm_loadu_si128(va + 3), _mm_loadu_si128(vb + 3))));
+    return _mm_movemask_epi8(all) != 0xFFFF;
+#    else
+    const uint64x2_t any = vreinterpretq_u64_u8(vorrq_u8(
+        vorrq_u8(veorq_u8(vld1q_u8(a), vld1q_u8(b)), veorq_u8(vld1q_u8(a + 16), vld1q_u8(b + 16))),
+        vorrq_u8(veorq_u8(vld1q_u8(a + 32), vld1q_u8(b + 32)), veorq_u8(vld1q_u8(a + 48), vld1q_u8(b + 48)))));
+    return (vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)) != 0U;
+#    endif
+}
+#endif
+
+size_t runit_nonzero_offset(const void* const data, const size_t length)
+{
+    const uint8_t* const bytes = (const uint8_t*) data;
+    size_t               i     = 0;
+
+    /* Single bytes up to the first aligned word */
+    for (; i < length && (uintptr_t) (bytes + i) % sizeof(uintptr_t) != 0U; i++)
+    {
+        if (bytes[i] != 0U)
+        {
+            return i;
+        }
+    }
+#if defined(RUNIT_SCAN_BLOCK)
+    for (; length - i >= RUNIT_SCAN_BLOCK && !runit_block_nonzero(&bytes[i]); i += RUNIT_SCAN_BLOCK)
+    {
+    }
+#endif
+    /* Whole words; memcpy() is a plain aligned load, without aliasing issues */
+    for (; length - i >= sizeof(uintptr_t); i += sizeof(uintptr_t))
+    {
+        uintptr_t word;
+        memcpy(&word, &bytes[i], sizeof(word));
+        if (word != 0U)
+        {
+            break;
+        }
+    }
+    /* The word holding the non-zero byte, or the tail */
+    for (; i < length; i++)
+    {
+        if (bytes[i] != 0U)
+        {
+            return i;
+        }
+    }
+    return length;
+}
+
+/* Stores type and value of an operand into 3 arguments of a record; floating
+ * point values as double, pointers as their address. */
+static void runit_put_value(uint32_t* const args, const runit_value_t* const value)
+{
+    uint64_t bits = 0;
+
+    args[0] = (uint32_t) value->type;
+    switch (value->type)
+    {
+        case RUNIT_VALUE_SIGNED: bits = (uint64_t) value->as.i; break;
+        case RUNIT_VALUE_UNSIGNED: bits = value->as.u; break;
+        case RUNIT_VALUE_FLOAT: runit_put_double(&args[1], (double) value->as.f); return;
+        case RUNIT_VALUE_DOUBLE: runit_put_double(&args[1], value->as.d); return;
+        case RUNIT_VALUE_LONG_DOUBLE: runit_put_double(&args[1], (double) value->as.ld); return;
+        case RUNIT_VALUE_POINTER: bits = (uint64_t) (uintptr_t) value->as.p; break;
+        default: break;
+    }
+    args[1] = (uint32_t) bits;
+    args[2] = (uint32_t) (bits >> 32U);
+}
+
+RUNIT_COLD void runit_report_comparison_failure(const runit_site_t* const  site,
+                                                const runit_value_t* const a,
+                                                const runit_value_t* const b)
+{
+    runit_record_t record = {site, {0}, RUNIT_COMPARISON_ARGS};
+
+    runit_put_value(&record.args[0], a);
+    runit_put_value(&record.args[3], b);
+    runit_fail_with(&record);
+}
+
+RUNIT_COLD void runit_report_zeros_failure(const runit_site_t* const site, const size_t offset)
+{
+    const runit_record_t record = {site, {runit_saturate_u32(offset)}, 1};
+
+    runit_fail_with(&record);
+}
+
+size_t runit_mismatch_offset(const void* const a, const void* const b, const size_t length)
+{
+    const uint8_t* const bytes_a = (const uint8_t*) a;
+    const uint8_t* const bytes_b = (const uint8_t*) b;
+    size_t               i       = 0;
+
+    /* Single bytes up to the first aligned word of a; b may stay unaligned */
+    for (; i < length && (uintptr_t) (bytes_a + i) % sizeof(uintptr_t) != 0U; i++)
+    {
+        if (bytes_a[i] != bytes_b[i])
+        {
+            return i;
+        }
+    }
+#if defined(RUNIT_SCAN_BLOCK)
+    for (; length - i >= RUNIT_SCAN_BLOCK && !runit_blocks_differ(&bytes_a[i], &bytes_b[i]); i += RUNIT_SCAN_BLOCK)
+    {
+    }
+#endif
+    for (; length - i >= sizeof(uintptr_t); i += sizeof(uintptr_t))
+    {
+        uintptr_t word_a;
+        uintptr_t word_b;
+        memcpy(&word_a, &bytes_a[i], sizeof(word_a));
+        memcpy(&word_b, &bytes_b[i], sizeof(word_b));
+        if (word_a != word_b)
+        {
+            break;
+        }
+    }
+    for (; i < length; i++)
+    {
+        if (bytes_a[i] != bytes_b[i])
+        {
+            return i;
+        }
+    }
+    return length;
+}
+
+RUNIT_COLD void runit_report_memeq_failure(const runit_site_t* const site,
+                                           const void* const         a,
+                                           const void* const         b,
+                                           const size_t              length)
+{
+    const size_t   offset = runit_mismatch_offset(a, b, length);
+    const size_t   count  = length < RUNIT_MEMEQ_WINDOW ? length : RUNIT_MEMEQ_WINDOW;
+    size_t         start  = offset > 3U ? offset - 3U : 0U; /* The difference as 4th byte */
+    runit_record_t record = {site, {0}, RUNIT_ELEMENT_ARGS};
+
+    if (start > length - count)
+    {
+        start = length - count;
+    }
+    record.args[0] = runit_saturate_u32(offset);
+    record.args[1] = runit_saturate_u32(start);
+    record.args[2] = (uint32_t) count;
+    for (size_t i = 0; i < count; i++)
+    {
+        record.args[3U + i / 4U] |= (uint32_t) ((const uint8_t*) a)[start + i] << (8U * (i % 4U));
+        record.args[5U + i / 4U] |= (uint32_t) ((const uint8_t*) b)[start + i] << (8U * (i % 4U));
+    }
+    runit_fail_with(&record);
+}
+
+int runit_farray_within(const float* const a, const float* const b, const size_t count, const float delta)
+{
+    const float tolerance = fabsf(delta);
+    size_t      i         = 0;
+
+    /* NaN is outside of any tolerance: compare with "not less or equal" */
+#if defined(__AVX__)
+    const __m256 limit   = _mm256_set1_ps(tolerance);
+    const __m256 sign    = _mm256_set1_ps(-0.0f);
+    __m256       outside = _mm256_setzero_ps();
+    for (; count - i >= 8U; i += 8U)
+    {
+        const __m256 error = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i])));
+        outside            = _mm256_or_ps(outside, _mm256_cmp_ps(error, limit, _CMP_NLE_UQ));
+    }
+    if (_mm256_movemask_ps(outside) != 0)
+    {
+        return 0;
+    }
+#elif defined(__SSE2__)
+    const __m128 limit   = _mm_set1_ps(tolerance);
+    const __m128 sign    = _mm_set1_ps(-0.0f);
+    __m128       outside = _mm_setzero_ps();
+    for (; count - i >= 4U; i += 4U)
+    {
+        const __m128 error = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(&a[i]), _mm_loadu_ps(&b[i])));
+        outside            = _mm_or_ps(outside, _mm_cmpnle_ps(error, limit));
+    }
+    if (_mm_movemask_ps(outside) != 0)
+    {
+        return 0;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t limit  = vdupq_n_f32(tolerance);
+    uint32x4_t        inside = vdupq_n_u32(UINT32_MAX);
+    for (; count - i >= 4U; i += 4U)
+    {
+        inside = vandq_u32(inside, vcleq_f32(vabdq_f32(vld1q_f32(&a[i]), vld1q_f32(&b[i])), limit));
+    }
+    if (vminvq_u32(inside) == 0U)
+    {
+        return 0;
+    }
+#endif
+    for (; i < count; i++)
+    {
+        if (!(fabsf(a[i] - b[i]) <= tolerance))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int runit_darray_within(const double* const a, const double* const b, const size_t count, const double delta)
+{
+    const double tolerance = fabs(delta);
+    size_t       i         = 0;
+
+#if defined(__AVX__)
+    const __m256d limit   = _mm256_set1_pd(tolerance);
+    const __m256d sign    = _mm256_set1_pd(-0.0);
+    __m256d       outside = _mm256_setzero_pd();
+    for (; count - i >= 4U; i += 4U)
+    {
+        const __m256d error = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(&a[i]), _mm256_loadu_pd(&b[i])));
+        outside             = _mm256_or_pd(outside, _mm256_cmp_pd(error, limit, _CMP_NLE_UQ));
+    }
+    if (_mm256_movemask_pd(outside) != 0)
+    {
+        return 0;
+    }
+#elif defined(__SSE2__)
+    const __m128d limit   = _mm_set1_pd(tolerance);
+    const __m128d sign    = _mm_set1_pd(-0.0);
+    __m128d       outside = _mm_setzero_pd();
+    for (; count - i >= 2U; i += 2U)
+    {
+        const __m128d error = _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(&a[i]), _mm_loadu_pd(&b[i])));
+        outside             = _mm_or_pd(outside, _mm_cmpnle_pd(error, limit));
+    }
+    if (_mm_movemask_pd(outside) != 0)
+    {
+        return 0;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float64x2_t limit  = vdupq_n_f64(tolerance);
+    uint64x2_t        inside = vdupq_n_u64(UINT64_MAX);
+    for (; count - i >= 2U; i += 2U)
+    {
+        inside = vandq_u64(inside, vcleq_f64(vabdq_f64(vld1q_f64(&a[i]), vld1q_f64(&b[i])), limit));
+    }
+    if (vminvq_u32(vreinterpretq_u32_u64(inside)) == 0U)
+    {
+        return 0;
+    }
+#endif
+    for (; i < count; i++)
+    {
+        if (!(fabs(a[i] - b[i]) <= tolerance))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Index of the largest error, or of the first NaN error. */
+#define RUNIT_WORST_ELEMENT(a, b, count, fabs_function, worst)   \
+    do                                                           \
+    {                                                            \
+        double largest = 0;                                      \
+        for (size_t i = 0; i < (count); i++)                     \
+        {                                                        \
+            const double error = fabs_function((a)[i] - (b)[i]); \
+            if (isnan(error))                                    \
+            {                                                    \
+                (worst) = i;                                     \
+                break;                                           \
+            }                                                    \
+            if (error > largest)                                 \
+            {                                                    \
+                largest = error;                                 \
+                (worst) = i;                                     \
+            }                                                    \
+        }                                                        \
+    } while (0)
+
+RUNIT_COLD void runit_report_farray_failure(const runit_site_t* const site,
+                                            const float* const        a,
+                                            const float* const        b,
+                                            const size_t              count)
+{
+    runit_record_t record = {site, {0}, RUNIT_ELEMENT_ARGS};
+    size_t         worst  = 0;
+
+    RUNIT_WORST_ELEMENT(a, b, count, fabsf, worst);
+    record.args[0] = runit_saturate_u32(worst);
+    runit_put_double(&record.args[1], (double) a[worst]);
+    runit_put_double(&record.args[3], (double) b[worst]);
+    runit_put_double(&record.args[5], (double) fabsf(a[worst] - b[worst]));
+    runit_fail_with(&record);
+}
+
+RUNIT_COLD void runit_report_darray_failure(const runit_site_t* const site,
+                                            const double* const       a,
+                                            const double* const       b,
+                                            const size_t              count)
+{
+    runit_record_t record = {site, {0}, RUNIT_ELEMENT_ARGS};
+    size_t         worst  = 0;
+
+    RUNIT_WORST_ELEMENT(a, b, count, fabs, worst);
+    record.args[0] = runit_saturate_u32(worst);
+    runit_put_double(&record.args[1], a[worst]);
+    runit_put_double(&record.args[3], b[worst]);
+    runit_put_double(&record.args[5], fabs(a[worst] - b[worst]));
+    runit_fail_with(&record);
+}
+
+/* Bit patterns of floats mapped to integers in the same order as the values:
+ * the sign-magnitude encoding becomes two's complement, -0.0 maps to 0. */
+static int32_t runit_fkey(const int32_t bits)
+{
+    const int32_t negative = bits >> 31; /* All ones if negative */
+    return ((bits & INT32_MAX) ^ negative) - negative;
+}
+
+static int64_t runit_dkey(const int64_t bits)
+{
+    const int64_t negative = bits >> 63;
+    return ((bits & INT64_MAX) ^ negative) - negative;
+}
+
+/* Difference of two keys; exact as unsigned, as keys of non-NaN values lie
+ * between the ones of -infinity and +infinity. */
+#define RUNIT_KEY_DISTANCE(type, a, b) ((a) > (b) ? (type) (a) - (type) (b) : (type) (b) - (type) (a))
+
+#define RUNIT_FLOAT_INFINITY_BITS  0x7F800000
+#define RUNIT_DOUBLE_INFINITY_BITS 0x7FF0000000000000
+
+/* Elements per block of the ULP kernels, a multiple of every vector width:
+ * a fixed inner loop without branches is vectorized by GCC and Clang at
+ * -O2, on any SIMD instruction set. */
+#define RUNIT_ULP_BLOCK 16U
+
+uint32_t runit_fulp_distance(const float a, const float b)
+{
+    int32_t bits_a;
+    int32_t bits_b;
+
+    memcpy(&bits_a, &a, sizeof(bits_a));
+    memcpy(&bits_b, &b, sizeof(bits_b));
+    if (isnan(a) || isnan(b))
+    {
+        return UINT32_MAX;
+    }
+    return RUNIT_KEY_DISTANCE(uint32_t, runit_fkey(bits_a), runit_fkey(bits_b));
+}
+
+uint64_t runit_dulp_distance(const double a, const double b)
+{
+    int64_t bits_a;
+    int64_t bits_b;
+
+    memcpy(&bits_a, &a, sizeof(bits_a));
+    memcpy(&bits_b, &b, sizeof(bits_b));
+    if (isnan(a) || isnan(b))
+    {
+        return UINT64_MAX;
+    }
+    return RUNIT_KEY_DISTANCE(uint64_t, runit_dkey(bits_a), runit_dkey(bits_b));
+}
+
+int runit_farray_ulp_within(const float* const a, const float* const b, const size_t count, const uint32_t maxulps)
+{
+    uint32_t outside = 0;
+    size_t   i       = 0;
+
+    for (; count - i >= RUNIT_ULP_BLOCK; i += RUNIT_ULP_BLOCK)
+    {
+        int32_t bits_a[RUNIT_ULP_BLOCK];
+        int32_t bits_b[RUNIT_ULP_BLOCK];
+        memcpy(bits_a, &a[i], sizeof(bits_a));
+        memcpy(bits_b, &b[i], sizeof(bits_b));
+        for (size_t j = 0; j < RUNIT_ULP_BLOCK; j++)
+        {
+            const int32_t key_a = runit_fkey(bits_a[j]);
+            const int32_t key_b = runit_fkey(bits_b[j]);
+            outside |= (uint32_t) (RUNIT_KEY_DISTANCE(uint32_t, key_a, key_b) > maxulps)
+                       | (uint32_t) ((bits_a[j] & INT32_MAX) > RUNIT_FLOAT_INFINITY_BITS)
+                       | (uint32_t) ((bits_b[j] & INT32_MAX) > RUNIT_FLOAT_INFINITY_BITS);
+        }
+    }
+    for (; i < count && outside == 0U; i++)
+    {
+        outside = runit_fulp_distance(a[i], b[i]) > maxulps;
+    }
+    return outside == 0U;
+}
+
+int runit_darray_ulp_within(const double* const a, const double* const b, const size_t count, const uint64_t maxulps)
+{
+    uint64_t outside = 0;
+    size_t   i       = 0;
+
+    for (; count - i >= RUNIT_ULP_BLOCK; i += RUNIT_ULP_BLOCK)
+    {
+        int64_t bits_a[RUNIT_ULP_BLOCK];
+        int64_t bits_b[RUNIT_ULP_BLOCK];
+        memcpy(bits_a, &a[i], sizeof(bits_a));
+        memcpy(bits_b, &b[i], sizeof(bits_b));
+        for (size_t j = 0; j < RUNIT_ULP_BLOCK; j++)
+        {
+            const int64_t key_a = runit_dkey(bits_a[j]);
+            const int64_t key_b = runit_dkey(bits_b[j]);
+            outside |= (uint64_t) (RUNIT_KEY_DISTANCE(uint64_t, key_a, key_b) > maxulps)
+                       | (uint64_t) ((bits_a[j] & INT64_MAX) > RUNIT_DOUBLE_INFINITY_BITS)
+                       | (uint64_t) ((bits_b[j] & INT64_MAX) > RUNIT_DOUBLE_INFINITY_BITS);
+        }
+    }
+    for (; i < count && outside == 0U; i++)
+    {
+        outside = runit_dulp_distance(a[i], b[i]) > maxulps;
+    }
+    return outside == 0U;
+}
+
+/* Without fmax(), which is not a builtin: runit does not need libm. */
+int runit_fclose_within(const float a, const float b, const float abstol, const float reltol)
+{
+    const float relative = fabsf(reltol) * (fabsf(a) > fabsf(b) ? fabsf(a) : fabsf(b));
+    const float error    = fabsf(a - b);
+    return a == b || error <= fabsf(abstol) || error <= relative;
+}
+
+int runit_dclose_within(const double a, const double b, const double abstol, const double reltol)
+{
+    const double relative = fabs(reltol) * (fabs(a) > fabs(b) ? fabs(a) : fabs(b));
+    const double error    = fabs(a - b);
+    return a == b || error <= fabs(abstol) || error <= relative;
+}
+
+RUNIT_COLD void runit_report_ulp_failure(const runit_site_t* const site, const uint64_t distance, const uint64_t maxulps)
+{
+    const runit_record_t record = {
+        site,
+        {(uint32_t) distance, (uint32_t) (distance >> 32U), (uint32_t) maxulps, (uint32_t) (maxulps >> 32U)},
+        4};
+
+    runit_fail_with(&record);
+}
+
+/* Index of the element at the largest ULP distance. */
+#define RUNIT_WORST_ULP(a, b, count, distance_function, worst)       \
+    do                                                               \
+    {                                                                \
+        uint64_t largest = 0;                                        \
+        for (size_t i = 0; i < (count); i++)                         \
+        {                                                            \
+            const uint64_t ulps = distance_function((a)[i], (b)[i]); \
+            if (ulps > largest)                                      \
+            {                                                        \
+                largest = ulps;                                      \
+                (worst) = i;                                         \
+            }                                                        \
+        }                                                            \
+    } while (0)
+
+RUNIT_COLD void runit_report_farray_ulp_failure(const runit_site_t* const site,
+                                                const float* const        a,
+                                                const float* const        b,
+                                                const size_t              count)
+{
+    runit_record_t record = {site, {0}, RUNIT_ELEMENT_ARGS};
+    size_t         worst  = 0;
+    uint64_t       distance;
+
+    RUNIT_WORST_ULP(a, b, count, runit_fulp_distance, worst);
+    distance       = runit_fulp_distance(a[worst], b[worst]);
+    record.args[0] = runit_saturate_u32(worst);
+    runit_put_double(&record.args[1], (double) a[worst]);
+    runit_put_double(&record.args[3], (double) b[worst]);
+    record.args[5] = (uint32_t) distance;
+    record.args[6] = (uint32_t) (distance >> 32U);
+    runit_fail_with(&record);
+}
+
+RUNIT_COLD void runit_report_darray_ulp_failure(const runit_site_t* const site,
+                                                const double* const       a,
+                                                const double* const       b,
+                                                const size_t              count)
+{
+    runit_record_t record = {site, {0}, RUNIT_ELEMENT_ARGS};
+    size_t         worst  = 0;
+    uint64_t       distance;
+
+    RUNIT_WORST_ULP(a, b, count, runit_dulp_distance, worst);
+    distance       = runit_dulp_distance(a[worst], b[worst]);
+    record.args[0] = runit_saturate_u32(worst);
+    runit_put_double(&record.args[1], a[worst]);
+    runit_put_double(&record.args[3], b[worst]);
+    record.args[5] = (uint32_t) distance;
+    record.args[6] = (uint32_t) (distance >> 32U);
+    runit_fail_with(&record);
+}
+
+/* Element of an integer array, zero-extended to 64 bits; larger elements are
+ * cut to their first 8 bytes. */
+static uint64_t runit_element(const void* const array, const size_t index, const size_t size)
+{
+    const uint8_t* const element = (const uint8_t*) array + index * size;
+    uint8_t              u8;
+    uint16_t             u16;
+    uint32_t             u32;
+    uint64_t             u64;
+
+    switch (size)
+    {
+        case 1U: memcpy(&u8, element, size); return u8;
+        case 2U: memcpy(&u16, element, size); return u16;
+        case 4U: memcpy(&u32, element, size); return u32;
+        default:
+            u64 = 0;
+            memcpy(&u64, element, size < sizeof(u64) ? size : sizeof(u64));
+            return u64;
+    }
+}
+
+RUNIT_COLD void runit_report_array_failure(const runit_site_t* const site,
+                                           const void* const         a,
+                                           const void* const         b,
+                                           const size_t              count,
+                                           const size_t              size)
+{
+    const size_t   index  = runit_mismatch_offset(a, b, count * size) / size;
+    runit_record_t record = {site, {0}, 6};
+    uint64_t       value;
+
+    record.args[0] = runit_saturate_u32(index);
+    record.args[1] = (uint32_t) (size < sizeof(value) ? size : sizeof(value));
+    value          = runit_element(a, index, size);
+    record.args[2] = (uint32_t) value;
+    record.args[3] = (uint32_t) (value >> 32U);
+    value          = runit_element(b, index, size);
+    record.args[4] = (uint32_t) value;
+    record.args[5] = (uint32_t) (value >> 32U);
+    runit_fail_with(&record);
+}
+
+#if RUNIT_HAVE_PARALLEL
+/* Results of one worker process, written by the worker only. */
+typedef struct runit_worker
+{
+    pid_t        pid;
+    unsigned int passes;
+    unsigned int failures;
+} runit_worker_t;
+
+/* Shared between the runner and its workers. */
+typedef struct runit_shared
+{
+    atomic_uint    next;     /* Index of the next test case to run */
+    atomic_uint    reported; /* Whether a worker reported the end of the whole run */
+    runit_worker_t workers[];
+} runit_shared_t;
+
+/* Duration of the test cases no worker ran, e.g. after a crash. */
+#    define RUNIT_TIME_NOT_RUN UINT32_MAX
+
+static void runit_work(runit_shared_t* const shared, runit_worker_t* const worker, uint32_t* const times)
+{
+    const runit_test_t* const tests    = runit_tests_begin();
+    const unsigned int        count    = (unsigned int) runit_test_count();
+    unsigned int              passes;
+    unsigned int              failures;
+
+    runit_counters_merge();
+    passes                 = runit_counter_assert_passes;
+    failures               = runit_counter_assert_failures;
+    runit_timeout_reported = &shared->reported;
+
+#    if RUNIT_HAVE_SINK_FD
+    if (runit_sink == runit_sink_stdout)
+    {
+        runit_set_sink(runit_sink_fd, (void*) (intptr_t) STDOUT_FILENO);
+    }
+#    endif
+    for (;;)
+    {
+        const unsigned int index = atomic_fetch_add_explicit(&shared->next, 1U, memory_order_relaxed);
+        if (index >= count || runit_timeout_passed(index))
+        {
+            break;
+        }
+        if (!runit_in_shard(index))
+        {
+            continue;
+        }
+        times[index] = runit_run_test(&tests[index]);
+        runit_counters_merge();
+        /* Kept up to date, so the results survive a crash in a later test */
+        worker->passes   = runit_counter_assert_passes - passes;
+        worker->failures = runit_counter_assert_failures - failures;
+    }
+    runit_flush();
+    fflush(stdout);
+    _exit(0);
+}
+
+static void runit_run_parallel(size_t jobs)
+{
+    const size_t    count  = runit_test_count();
+    const size_t    size   = sizeof(runit_shared_t) + jobs * sizeof(runit_worker_t) + count * sizeof(uint32_t);
+    const uint64_t  start  = runit_clock_ns();
+    runit_shared_t* shared = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    uint32_t*       times;
+
+    if (shared == MAP_FAILED)
+    {
+        runit_run_all();
+        return;
+    }
+    times = (uint32_t*) (void*) &shared->workers[jobs];
+    for (size_t i = 0; i < count; i++)
+    {
+        times[i] = RUNIT_TIME_NOT_RUN;
+    }
+    atomic_init(&shared->next, 0U);
+    atomic_init(&shared->reported, 0U);
+    runit_timeout_start();
+    runit_flush();
+    fflush(stdout); /* Otherwise each worker would print it again */
+    for (size_t i = 0; i < jobs; i++)
+    {
+        pid_t pid;
+
+        shared->workers[i].passes   = 0;
+        shared->workers[i].failures = 0;
+        pid                         = fork();
+        if (pid == 0)
+        {
+            runit_work(shared, &shared->workers[i], times);
+        }
+        if (pid < 0)
+        {
+            jobs = i; /* The started workers take over the rest */
+            break;
+        }
+        shared->workers[i].pid = pid; /* Only by the runner, the slot is shared */
+    }
+    if (jobs == 0)
+    {
+        runit_run_all();
+    }
+    for (size_t i = 0; i < jobs; i++)
+    {
+        int status = 0;
+
+        while (waitpid(shared->workers[i].pid, &status, 0) < 0 && errno == EINTR)
+        {
+        }
+        runit_counter_assert_passes += shared->workers[i].passes;
+        runit_counter_assert_failures += shared->workers[i].failures;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            runit_counter_assert_failures++;
+        }
+    }
+    if (runit_counter_assert_failures > 0)
+    {
+        runit_at_least_one_fail = 1;
+    }
+    if (jobs > 0)
+    {
+        runit_times_reset();
+        for (size_t i = 0; i < count; i++)
+        {
+            if (times[i] != RUNIT_TIME_NOT_RUN)
+            {
+                runit_times_add(i, times[i]);
+            }
+        }
+        runit_times_wall = (runit_clock_ns() - start) / 1000U;
+    }
+    munmap(shared, size);
+}
+#endif
+
+#if RUNIT_HAVE_CLOCK_MONOTONIC
+uint64_t runit_clock_monotonic(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000U + (uint64_t) now.tv_nsec;
+}
+#endif
+
+#if RUNIT_HAVE_CLOCK_RDTSC
+uint64_t runit_clock_rdtsc(void)
+{
+    uint32_t low;
+    uint32_t high;
+
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return (uint64_t) high << 32U | low;
+}
+#endif
+
+uint64_t runit_clock_extend32(uint64_t* const extended, const uint32_t counter)
+{
+    uint64_t high = *extended & ~(uint64_t) UINT32_MAX;
+
+    if (counter < (uint32_t) *extended)
+    {
+        high += (uint64_t) UINT32_MAX + 1U; /* Wrapped around since the previous call */
+    }
+    *extended = high | counter;
+    return *extended;
+}
+
+#if defined(RUNIT_CLOCK_DWT)
+#    if !defined(RUNIT_CPU_HZ)
+#        error "RUNIT_CLOCK_DWT requires RUNIT_CPU_HZ"
+#    endif
+/* Architectural addresses of the ARMv7-M and ARMv8-M debug registers. */
+#    define RUNIT_DEMCR          (*(volatile uint32_t*) 0xE000EDFCU)
+#    define RUNIT_DEMCR_TRCENA   (1UL << 24U)
+#    define RUNIT_DWT_CTRL       (*(volatile uint32_t*) 0xE0001000U)
+#    define RUNIT_DWT_CYCCNTENA  (1UL << 0U)
+#    define RUNIT_DWT_CYCCNT     (*(volatile uint32_t*) 0xE0001004U)
+#    define RUNIT_DWT_LAR        (*(volatile uint32_t*) 0xE0001FB0U)
+#    define RUNIT_DWT_LAR_UNLOCK 0xC5ACCE55U
+
+uint64_t runit_clock_dwt(void)
+{
+    static uint64_t extended = 0;
+    static char     enabled  = 0;
+
+    if (!enabled)
+    {
+        RUNIT_DEMCR |= RUNIT_DEMCR_TRCENA;
+        RUNIT_DWT_LAR = RUNIT_DWT_LAR_UNLOCK; /* Needed by the Cortex-M7 only */
+        RUNIT_DWT_CYCCNT = 0;
+        RUNIT_DWT_CTRL |= RUNIT_DWT_CYCCNTENA;
+        enabled = 1;
+    }
+    return runit_clock_extend32(&extended, RUNIT_DWT_CYCCNT);
+}
+#endif
+
+#if defined(RUNIT_HARDFAULT_HANDLER)
+#    if !defined(__ARM_ARCH_7M__) && !defined(__ARM_ARCH_7EM__) && !defined(__ARM_ARCH_8M_MAIN__)
+#        error "RUNIT_HARDFAULT_HANDLER needs the fault status registers of an ARMv7-M or ARMv8-M core"
+#    endif
+/* Architectural addresses of the fault and reset registers of the System Control Block. */
+#    define RUNIT_SCB_AIRCR             (*(volatile uint32_t*) 0xE000ED0CU)
+#    define RUNIT_SCB_AIRCR_SYSRESETREQ (0x05FA0000UL | (1UL << 2U)) /* With the write key */
+#    define RUNIT_SCB_CFSR              (*(volatile uint32_t*) 0xE000ED28U)
+#    define RUNIT_SCB_HFSR              (*(volatile uint32_t*) 0xE000ED2CU)
+#    define RUNIT_SCB_MMFAR             (*(volatile uint32_t*) 0xE000ED34U)
+#    define RUNIT_SCB_BFAR              (*(volatile uint32_t*) 0xE000ED38U)
+
+/* Second half of HardFault_Handler(), with the registers stacked on exception
+ * entry: r0, r1, r2, r3, r12, lr, pc, xpsr. */
+__attribute__((used)) static void runit_hardfault(const uint32_t* const frame)
+{
+    const runit_fault_t fault = {
+        frame[6], frame[5], frame[7], RUNIT_SCB_CFSR, RUNIT_SCB_HFSR, RUNIT_SCB_MMFAR, RUNIT_SCB_BFAR};
+
+    if (runit_fail_fault(&fault))
+    {
+        __asm volatile("dsb" ::: "memory"); /* The cause is in RAM before the reset */
+        RUNIT_SCB_AIRCR = RUNIT_SCB_AIRCR_SYSRESETREQ;
+        __asm volatile("dsb" ::: "memory");
+    }
+    for (;;)
+    {
+    }
+}
+
+/* Bit 2 of EXC_RETURN tells the stack the frame was pushed onto. */
+__attribute__((naked)) void HardFault_Handler(void)
+{
+    __asm volatile("tst lr, #4\n"
+                   "ite eq\n"
+                   "mrseq r0, msp\n"
+                   "mrsne r0, psp\n"
+                   "b runit_hardfault\n");
+}
+#endif
+
+uint64_t runit_clock_std(void)
+{
+    return (uint64_t) clock() * (1000000000U / CLOCKS_PER_SEC);
+}
+
+void runit_set_clock(const runit_clock_t clock, const char* const unit)
+{
+    runit_clock            = clock != NULL ? clock : RUNIT_CLOCK;
+    runit_clock_unit       = clock != NULL ? unit : RUNIT_CLOCK_UNIT;
+    runit_clock_calibrated = UINT64_MAX;
+}
+
+uint64_t runit_clock_now(void)
+{
+    return runit_clock();
+}
+
+/* Smallest difference between two consecutive readings of the clock. */
+static uint64_t runit_measure_overhead(const runit_clock_t clock)
+{
+    uint64_t overhead = UINT64_MAX;
+
+    for (unsigned int i = 0; i < 64U; i++)
+    {
+        const uint64_t start = clock();
+        const uint64_t end   = clock();
+        if (end - start < overhead)
+        {
+            overhead = end - start;
+        }
+    }
+    return overhead;
+}
+
+uint64_t runit_clock_overhead(void)
+{
+    if (runit_clock_calibrated == UINT64_MAX)
+    {
+        runit_clock_calibrated = runit_measure_overhead(runit_clock);
+    }
+    return runit_clock_calibrated;
+}
+
+uint64_t runit_clock_ns(void)
+{
+#if defined(RUNIT_CLOCK_DWT)
+    const uint64_t cycles = runit_clock_dwt();
+    const uint64_t hz     = (uint64_t) (RUNIT_CPU_HZ);
+
+    return cycles / hz * 1000000000U + cycles % hz * 1000000000U / hz;
+#elif RUNIT_HAVE_CLOCK_MONOTONIC
+    return runit_clock_monotonic();
+#else
+    return runit_clock_std();
+#endif
+}
+
+#if RUNIT_HAVE_CLOCK_CYCLES
+uint64_t runit_clock_cycles(void)
+{
+#    if defined(RUNIT_CLOCK_DWT)
+    return runit_clock_dwt();
+#    else
+    return runit_clock_rdtsc();
+#    endif
+}
+#endif
+
+static uint64_t runit_timing_samples[RUNIT_TIMING_SAMPLES];
+
+void runit_timing_begin(runit_timing_t* const  timing,
+                        const runit_clock_t     clock,
+                        const runit_statistic_t statistic,
+                        const unsigned long     repeats)
+{
+    timing->clock     = clock;
+    timing->start     = 0;
+    timing->overhead  = runit_measure_overhead(clock);
+    timing->value     = 0;
+    timing->repeats   = (uint32_t) (repeats < 1U ? 1U : repeats < RUNIT_TIMING_SAMPLES ? repeats : RUNIT_TIMING_SAMPLES);
+    timing->count     = 0;
+    timing->statistic = (uint32_t) statistic;
+}
+
+int runit_timing_next(runit_timing_t* const timing)
+{
+    const uint64_t elapsed = timing->clock() - timing->start;
+    uint32_t       count;
+
+    runit_timing_samples[timing->count++] = elapsed > timing->overhead ? elapsed - timing->overhead : 0U;
+    if (timing->count < timing->repeats)
+    {
+        return 1;
+    }
+    count = timing->count;
+    for (uint32_t i = 1; i < count; i++) /* Insertion sort, as the benchmarks */
+    {
+        const uint64_t sample = runit_timing_samples[i];
+        uint32_t       j      = i;
+        for (; j > 0 && runit_timing_samples[j - 1U] > sample; j--)
+        {
+            runit_timing_samples[j] = runit_timing_samples[j - 1U];
+        }
+        runit_timing_samples[j] = sample;
+    }
+    switch (timing->statistic)
+    {
+        case RUNIT_MIN: timing->value = runit_timing_samples[0]; break;
+        case RUNIT_MEDIAN:
+            timing->value = (runit_timing_samples[(count - 1U) / 2U] + runit_timing_samples[count / 2U]) / 2U;
+            break;
+        default: timing->value = runit_timing_samples[(count * 95U + 99U) / 100U - 1U]; break;
+    }
+    return 0;
+}
+
+RUNIT_COLD void runit_report_timing_failure(const runit_site_t* const    site,
+                                            const runit_timing_t* const timing,
+                                            const uint64_t              budget)
+{
+    const runit_record_t record = {
+        site,
+        {runit_saturate_u32(timing->value), runit_saturate_u32(budget), timing->statistic, timing->count},
+        4};
+
+    runit_fail_with(&record);
+}
+
+enum
+{
+    RUNIT_BENCH_CALIBRATING,
+    RUNIT_BENCH_WARMING_UP,
+    RUNIT_BENCH_MEASURING,
+};
+
+static uint64_t runit_bench_buffer[RUNIT_BENCH_SAMPLES];
+
+runit_bench_t runit_bench_begin(const runit_site_t* const site, uint64_t* const samples, const size_t capacity)
+{
+    runit_bench_t bench = {site, samples, capacity, 0, 0, 0, 0, RUNIT_BENCH_WARMUP, RUNIT_BENCH_CALIBRATING};
+
+    if (samples == NULL || capacity == 0)
+    {
+        bench.samples  = runit_bench_buffer;
+        bench.capacity = RUNIT_BENCH_SAMPLES;
+    }
+    (void) runit_clock_overhead(); /* Measured now, not within a sample */
+    return bench;
+}
+
+/* Square root without libm, by Newton's method. */
+static double runit_sqrt(const double value)
+{
+    double root = value > 1.0 ? value : 1.0;
+
+    if (value <= 0.0)
+    {
+        return 0.0;
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        const double next = 0.5 * (root + value / root);
+        if (next >= root)
+        {
+            break;
+        }
+        root = next;
+    }
+    return root;
+}
+
+void runit_bench_statistics(uint64_t* const samples,
+                            const size_t    count,
+                            const uint32_t  iterations,
+                            runit_bench_stats_t* const stats)
+{
+    uint64_t sum     = 0;
+    double   squares = 0.0;
+    double   mean;
+    double   stddev;
+
+    /* Insertion sort: few samples, no recursion, no qsort() callbacks */
+    for (size_t i = 1; i < count; i++)
+    {
+        const uint64_t sample = samples[i];
+        size_t         j      = i;
+        for (; j > 0 && samples[j - 1U] > sample; j--)
+        {
+            samples[j] = samples[j - 1U];
+        }
+        samples[j] = sample;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += samples[i];
+    }
+    mean = (double) sum / (double) count;
+    for (size_t i = 0; i < count; i++)
+    {
+        const double difference = (double) samples[i] - mean;
+        squares += difference * difference;
+    }
+    stddev = count > 1U ? runit_sqrt(squares / (double) (count - 1U)) : 0.0;
+
+    /* Per iteration, in hundredths */
+    stats->samples    = (uint32_t) count;
+    stats->iterations = iterations;
+    stats->min        = runit_saturate_u32(samples[0] * 100U / iterations);
+    stats->median     = runit_saturate_u32((samples[(count - 1U) / 2U] + samples[count / 2U]) * 50U / iterations);
+    stats->mean       = runit_saturate_u32((uint64_t) (mean * 100.0 / iterations + 0.5));
+    stats->p99        = runit_saturate_u32(samples[(count * 99U + 99U) / 100U - 1U] * 100U / iterations);
+    stats->stddev     = runit_saturate_u32((uint64_t) (stddev * 100.0 / iterations + 0.5));
+}
+
+int runit_bench_compare(const uint64_t* const           baseline,
+                        const size_t                    baseline_count,
+                        const uint64_t* const           current,
+                        const size_t                    current_count,
+                        runit_bench_comparison_t* const comparison)
+{
+    const double             n1 = (double) baseline_count;
+    const double             n2 = (double) current_count;
+    double                   u  = 0.0; /* Pairs with the current sample larger, ties halved */
+    runit_bench_comparison_t result;
+
+    for (size_t j = 0; j < current_count; j++)
+    {
+        for (size_t i = 0; i < baseline_count && baseline[i] <= current[j]; i++)
+        {
+            u += baseline[i] < current[j] ? 1.0 : 0.5;
+        }
+    }
+    result.baseline_median = (baseline[(baseline_count - 1U) / 2U] + baseline[baseline_count / 2U]) / 2U;
+    result.median          = (current[(current_count - 1U) / 2U] + current[current_count / 2U]) / 2U;
+    result.z               = (u - n1 * n2 / 2.0) / runit_sqrt(n1 * n2 * (n1 + n2 + 1.0) / 12.0);
+    if (comparison != NULL)
+    {
+        *comparison = result;
+    }
+    return result.median * 100U > result.baseline_median * (100U + RUNIT_BENCH_THRESHOLD_PERCENT)
+           && result.z >= RUNIT_BENCH_Z_CRITICAL;
+}
+
+static const char* runit_baseline_path       = NULL;
+static char        runit_baseline_update     = 0;
+static char        runit_baseline_configured = 0;
+static uint64_t    runit_baseline_buffer[RUNIT_BENCH_SAMPLES];
+
+void runit_bench_set_baseline(const char* const path, const int update)
+{
+    runit_baseline_path       = path;
+    runit_baseline_update     = (char) (update != 0);
+    runit_baseline_configured = 1;
+    if (path != NULL && update)
+    {
+        FILE* const file = fopen(path, "w"); /* Emptied once, then appended to */
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+    }
+}
+
+/* Is the key of a baseline line the one of this benchmark? */
+static int runit_baseline_matches(const char* const key, const runit_site_t* const site)
+{
+    const size_t length = strlen(site->function);
+
+    return strncmp(key, site->function, length) == 0 && key[length] == '/'
+           && strcmp(&key[length + 1U], site->expression) == 0;
+}
+
+/* Reads the samples of the benchmark, returns their amount, 0 without any. */
+static size_t runit_baseline_load(const runit_site_t* const site, uint64_t* const samples, const size_t capacity)
+{
+    FILE* const   file = fopen(runit_baseline_path, "r");
+    char          key[256];
+    unsigned long count;
+    size_t        loaded = 0;
+
+    if (file == NULL)
+    {
+        return 0;
+    }
+    while (loaded == 0 && fscanf(file, "%255s %lu", key, &count) == 2)
+    {
+        const int matches = runit_baseline_matches(key, site);
+        for (unsigned long i = 0; i < count; i++)
+        {
+            unsigned long long value;
+            if (fscanf(file, "%llu", &value) != 1)
+            {
+                break;
+            }
+            if (matches && loaded < capacity)
+            {
+                samples[loaded++] = value;
+            }
+        }
+    }
+    fclose(file);
+    return loaded;
+}
+
+static void runit_baseline_store(const runit_site_t* const site, const uint64_t* const samples, const size_t count)
+{
+    FILE* const file = fopen(runit_baseline_path, "a");
+
+    if (file == NULL)
+    {
+        return;
+    }
+    fprintf(file, "%s/%s %lu", site->function, site->expression, (unsigned long) count);
+    for (size_t i = 0; i < count; i++)
+    {
+        fprintf(file, " %llu", (unsigned long long) samples[i]);
+    }
+    fprintf(file, "\n");
+    fclose(file);
+}
+
+static void runit_baseline_from_environment(void)
+{
+    if (!runit_baseline_configured)
+    {
+        const char* const update = getenv("RUNIT_BASELINE_UPDATE");
+        runit_bench_set_baseline(getenv("RUNIT_BASELINE"), update != NULL && strcmp(update, "1") == 0);
+    }
+}
+
+/* Stores or checks the samples of a finished benchmark, see runit_bench_set_baseline(). */
+static void runit_baseline_check(runit_bench_t* const bench)
+{
+    runit_bench_comparison_t comparison;
+    size_t                   baseline_count;
+
+    runit_baseline_from_environment();
+    if (runit_baseline_path == NULL)
+    {
+        return;
+    }
+    /* Per iteration in hundredths from now on, as in the file; still sorted */
+    for (size_t i = 0; i < bench->count; i++)
+    {
+        bench->samples[i] = bench->samples[i] * 100U / bench->batch;
+    }
+    if (runit_baseline_update)
+    {
+        runit_baseline_store(bench->site, bench->samples, bench->count);
+        return;
+    }
+    baseline_count = runit_baseline_load(bench->site, runit_baseline_buffer, RUNIT_BENCH_SAMPLES);
+    if (baseline_count == 0)
+    {
+        return;
+    }
+    if (runit_bench_compare(runit_baseline_buffer, baseline_count, bench->samples, bench->count, &comparison))
+    {
+        const runit_record_t record = {bench->site,
+                                       {runit_saturate_u32(comparison.baseline_median),
+                                        runit_saturate_u32(comparison.median),
+                                        runit_saturate_u32((uint64_t) (comparison.z * 100.0))},
+                                       RUNIT_BENCH_REGRESSION_ARGS};
+        runit_fail_with(&record);
+    }
+    else
+    {
+        RUNIT_COUNT_PASS_();
+    }
+}
+
+int runit_bench_next(runit_bench_t* const bench)
+{
+    const uint64_t end      = runit_clock_now();
+    const uint64_t overhead = runit_clock_overhead();
+    const uint64_t elapsed  = end - bench->start > overhead ? end - bench->start - overhead : 0U;
+
+    if (bench->batch == 0)
+    {
+        bench->batch = 1; /* First call: nothing measured yet */
+    }
+    else if (bench->state == RUNIT_BENCH_CALIBRATING)
+    {
+        if (elapsed < RUNIT_BENCH_MIN_TICKS && bench->batch < (UINT32_C(1) << 30U))
+        {
+            bench->batch *= 2U;
+        }
+        else
+        {
+            bench->state = RUNIT_BENCH_WARMING_UP;
+        }
+    }
+    else if (bench->state == RUNIT_BENCH_WARMING_UP && bench->warmup > 0)
+    {
+        bench->warmup--;
+    }
+    else
+    {
+        bench->state                   = RUNIT_BENCH_MEASURING;
+        bench->samples[bench->count++] = elapsed;
+        if (bench->count == bench->capacity)
+        {
+            runit_bench_stats_t stats;
+            runit_record_t      record = {bench->site, {0}, 7};
+
+            runit_bench_statistics(bench->samples, bench->count, bench->batch, &stats);
+            record.args[0] = stats.samples;
+            record.args[1] = stats.iterations;
+            record.args[2] = stats.min;
+            record.args[3] = stats.median;
+            record.args[4] = stats.mean;
+            record.args[5] = stats.p99;
+            record.args[6] = stats.stddev;
+            runit_output(&record);
+            runit_baseline_check(bench);
+            return 0;
+        }
+    }
+    bench->remaining = bench->batch - 1U; /* This iteration is the first one */
+    bench->start     = runit_clock_now();
+    return 1;
+}
+
+/* Parses "index/count" of --shard, returns 0 on success. */
+static int runit_parse_shard(const char* const text, size_t* const index, size_t* const count)
+{
+    char* end = NULL;
+
+    if (*text < '0' || *text > '9')
+    {
+        return -1;
+    }
+    *index = strtoul(text, &end, 10);
+    if (*end != '/' || end[1] < '0' || end[1] > '9')
+    {
+        return -1;
+    }
+    *count = strtoul(&end[1], &end, 10);
+    return *end == '\0' && *index < *count ? 0 : -1;
+}
+
+/* Shard from RUNIT_SHARD_INDEX and RUNIT_SHARD_COUNT, if both are set. */
+static int runit_shard_from_environment(size_t* const index, size_t* const count)
+{
+    const char* const index_text = getenv("RUNIT_SHARD_INDEX");
+    const char* const count_text = getenv("RUNIT_SHARD_COUNT");
+    char              text[48];
+
+    if (index_text == NULL || count_text == NULL)
+    {
+        return 0;
+    }
+    snprintf(text, sizeof(text), "%s/%s", index_text, count_text);
+    return runit_parse_shard(text, index, count);
+}
+
+int runit_main(const int argc, char** const argv)
+{
+    const char* const times       = getenv("RUNIT_SHARD_TIMES");
+    const char* const update      = getenv("RUNIT_SHARD_TIMES_UPDATE");
+    const int         save_times  = times != NULL && update != NULL && strcmp(update, "1") == 0;
+    unsigned long     jobs        = 1;
+    size_t            shard       = 0;
+    size_t            shard_count = 0; /* No sharding */
+    uint32_t          test_ms     = 0;
+    uint32_t          total_ms    = 0;
+    int               invalid     = runit_shard_from_environment(&shard, &shard_count);
+
+    for (int i = 1; i < argc && !invalid; i++)
+    {
+        const char* value = NULL;
+        char*       end   = NULL;
+
+        if (strcmp(argv[i], "--catch-crashes") == 0)
+        {
+            runit_set_crash_recovery(1); /* Runs without it where not available */
+            continue;
+        }
+        if ((strcmp(argv[i], "--timeout") == 0 || strcmp(argv[i], "--total-timeout") == 0) && i + 1 < argc)
+        {
+            uint32_t* const     limit        = strcmp(argv[i], "--timeout") == 0 ? &test_ms : &total_ms;
+            const unsigned long milliseconds = strtoul(argv[++i], &end, 10);
+            invalid = *argv[i] < '0' || *argv[i] > '9' || *end != '\0' || milliseconds > UINT32_MAX;
+            *limit  = (uint32_t) milliseconds;
+            continue;
+        }
+        if (strcmp(argv[i], "--shard") == 0 && i + 1 < argc)
+        {
+            invalid = runit_parse_shard(argv[++i], &shard, &shard_count);
+            continue;
+        }
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            value = argv[++i];
+        }
+        else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0')
+        {
+            value = &argv[i][2];
+        }
+        if (value != NULL)
+        {
+            jobs = strtoul(value, &end, 10);
+        }
+        invalid = value == NULL || *value == '\0' || *end != '\0';
+    }
+    if (invalid || (shard_count > 0 && runit_set_shard(shard, shard_count, save_times ? NULL : times) != 0))
+    {
+        fprintf(stderr,
+                "Usage: %s [-j jobs] [--shard index/count] [--catch-crashes] [--timeout ms] [--total-timeout ms]\n",
+                argv[0]);
+        return 2;
+    }
+    if (shard_count > 0 && runit_shard_unplanned() > 0)
+    {
+        fprintf(stderr,
+                "%s: %lu test cases beyond RUNIT_TIMES_CAPACITY are dealt out in order, not balanced\n",
+                argv[0],
+                (unsigned long) runit_shard_unplanned());
+    }
+    if (test_ms > 0 || total_ms > 0)
+    {
+        runit_set_timeout(test_ms, total_ms); /* Runs without them where not available */
+    }
+    runit_baseline_from_environment(); /* Before the workers start */
+#if RUNIT_HAVE_PARALLEL
+    if (jobs == 0)
+    {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs            = cpus > 0 ? (unsigned long) cpus : 1UL;
+    }
+    if (jobs > runit_test_count())
+    {
+        jobs = runit_test_count();
+    }
+    if (jobs > 1)
+    {
+        runit_run_parallel(jobs);
+    }
+    else
+#endif
+    {
+        runit_run_all();
+    }
+    if (save_times)
+    {
+        runit_save_times(times);
+    }
+    runit_report_times();
+    runit_report();
+    return runit_at_least_one_fail ? 1 : 0;
+}
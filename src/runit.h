@@ -20,6 +20,7 @@ extern "C" {
 #include <math.h>   /* For fabs(), fabsf(), isnan(), isinf(), isfinite() */
 #include <string.h> /* For strncmp(), memcmp() */
 #include <stddef.h> /* For size_t */
+#include <stdint.h> /* For uint32_t, uint64_t */
 
 /**
  * Boolean indicating if all tests passed successfully (when 0) or not.
@@ -49,23 +50,1511 @@ extern unsigned int runit_counter_assert_failures;
  */
 extern unsigned int runit_counter_assert_passes;
 
+/**
+ * Thread-safe mode, enabled by defining `RUNIT_THREAD_SAFE` for the whole
+ * project (CMake option `RUNIT_THREAD_SAFE`), for assertions running in
+ * multiple threads at once.
+ *
+ * Each thread counts its passes and failures into its own slot, a cache line
+ * of a static array of #RUNIT_THREAD_SLOTS slots, without atomic
+ * read-modify-write operations on the hot path. Threads beyond that amount
+ * share one more slot with atomic increments. runit_counters_merge() adds the
+ * new counts of all slots to #runit_counter_assert_passes,
+ * #runit_counter_assert_failures and #runit_at_least_one_fail; runit_report(),
+ * runit_run_all() and runit_main() call it, otherwise call it before reading
+ * the globals.
+ *
+ * Custom sinks must be thread-safe too, and the deferred output still
+ * supports only one producer thread. Requires C11 atomics and `_Thread_local`.
+ */
+#if defined(RUNIT_THREAD_SAFE)
+#    if defined(__cplusplus) || defined(__STDC_NO_ATOMICS__)
+#        error "RUNIT_THREAD_SAFE requires a C11 compiler with atomics"
+#    endif
+#    include <stdatomic.h>
+
+/**
+ * Amount of threads with their own counters, the others share one slot.
+ * Only used by runit.c.
+ */
+#    ifndef RUNIT_THREAD_SLOTS
+#        define RUNIT_THREAD_SLOTS 64U
+#    endif
+
+/** Counters of one thread, see #RUNIT_THREAD_SAFE. */
+typedef struct runit_counters
+{
+    atomic_uint passes;
+    atomic_uint failures;
+} runit_counters_t;
+
+/** Slot of the current thread, NULL until its first assertion. */
+extern _Thread_local runit_counters_t* runit_thread_counters_;
+
+/** Claims a slot for the current thread, then counts one pass. */
+void runit_count_pass_slow_(void);
+
+/* Only the owning thread writes its slot: no read-modify-write needed. */
+#    define RUNIT_COUNT_PASS_()                                                                \
+        do                                                                                     \
+        {                                                                                      \
+            runit_counters_t* const runit_counters_ = runit_thread_counters_;                  \
+            if (RUNIT_LIKELY(runit_counters_ != NULL))                                         \
+            {                                                                                  \
+                atomic_store_explicit(                                                         \
+                    &runit_counters_->passes,                                                  \
+                    atomic_load_explicit(&runit_counters_->passes, memory_order_relaxed) + 1U, \
+                    memory_order_relaxed);                                                     \
+            }                                                                                  \
+            else                                                                               \
+            {                                                                                  \
+                runit_count_pass_slow_();                                                      \
+            }                                                                                  \
+        } while (0)
+#else
+#    define RUNIT_COUNT_PASS_() runit_counter_assert_passes++
+#endif
+
+/**
+ * Updates the global counters with the per-thread ones, see
+ * #RUNIT_THREAD_SAFE. Does nothing in the default mode, where the assertions
+ * update the globals directly.
+ */
+void runit_counters_merge(void);
+
 /**
  * Absolute tolerance when comparing two single-precision floating point
  * value for approximate-equality using runit_fapprox().
  *
- * If the difference between the two float values is bigger than this
- * tolerance, the assertion fails.
+ * If the difference between the two float values is bigger than this
+ * tolerance, the assertion fails.
+ */
+#define RUNIT_FLOAT_EQ_ABSTOL (1e-5f)
+
+/**
+ * Absolute tolerance when comparing two double-precision floating point
+ * value for approximate-equality using runit_dapprox().
+ *
+ * If the difference between the two double values is bigger than this
+ * tolerance, the assertion fails.
+ */
+#define RUNIT_DOUBLE_EQ_ABSTOL (1e-8)
+
+/**
+ * Hints the compiler that the expression is expected to be true, so the
+ * passing branch of an assertion is laid out as the fall-through path.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#    define RUNIT_LIKELY(x) __builtin_expect(!!(x), 1)
+#else
+#    define RUNIT_LIKELY(x) (x)
+#endif
+
+/**
+ * Marks a function as rarely executed and never inlined, so its body is kept
+ * out of the hot path and its call sites stay as small as possible.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#    define RUNIT_COLD __attribute__((cold, noinline))
+#elif defined(_MSC_VER)
+#    define RUNIT_COLD __declspec(noinline)
+#else
+#    define RUNIT_COLD
+#endif
+
+/**
+ * Name of the current source file, as printed by runit.
+ *
+ * With `RUNIT_NO_FULL_PATH` defined, only the file name is kept, without the
+ * directories (handles both Unix and Windows paths). Where possible this is
+ * resolved at compile time, so the full path does not end up in the binary:
+ * - with `__FILE_NAME__`, provided by GCC >= 12 and Clang >= 9;
+ * - in C++14 with a constexpr search for the last path separator (the full
+ *   path literal is still stored, but never searched at runtime).
+ *
+ * Otherwise the directories are stripped at runtime, and only on the failure
+ * and report paths in runit.c. The CMake option `RUNIT_NO_FULL_PATH` also
+ * passes `-fmacro-prefix-map` so `__FILE__` is at least relative to the
+ * project root in that case.
+ */
+#if defined(RUNIT_NO_FULL_PATH) && defined(__FILE_NAME__)
+#    define RUNIT_FILENAME  __FILE_NAME__
+#    define RUNIT_SITE_FILE RUNIT_FILENAME
+#elif defined(RUNIT_NO_FULL_PATH) && defined(__cplusplus) && __cplusplus >= 201402L
+static constexpr const char* runit_basename(const char* const path)
+{
+    const char* name = path;
+    for (const char* c = path; *c != '\0'; c++)
+    {
+        if (*c == '/' || *c == '\\')
+        {
+            name = c + 1;
+        }
+    }
+    return name;
+}
+#    define RUNIT_FILENAME  (runit_basename(__FILE__))
+#    define RUNIT_SITE_FILE RUNIT_FILENAME
+#elif defined(RUNIT_NO_FULL_PATH)
+#    define RUNIT_FILENAME                                   \
+        (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 \
+                                : (strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__))
+#    define RUNIT_SITE_FILE __FILE__
+#else
+#    define RUNIT_FILENAME  (__FILE__)
+#    define RUNIT_SITE_FILE __FILE__
+#endif
+
+/**
+ * Kind of assertion macro that created a call-site descriptor, one per
+ * public macro of runit.
+ */
+typedef enum runit_kind
+{
+    RUNIT_KIND_ASSERT = 0,
+    RUNIT_KIND_TRUE,
+    RUNIT_KIND_FALSE,
+    RUNIT_KIND_EQ,
+    RUNIT_KIND_NEQ,
+    RUNIT_KIND_GT,
+    RUNIT_KIND_GE,
+    RUNIT_KIND_LT,
+    RUNIT_KIND_LE,
+    RUNIT_KIND_FDELTA,
+    RUNIT_KIND_FAPPROX,
+    RUNIT_KIND_DDELTA,
+    RUNIT_KIND_DAPPROX,
+    RUNIT_KIND_NAN,
+    RUNIT_KIND_INF,
+    RUNIT_KIND_PLUSINF,
+    RUNIT_KIND_MINUSINF,
+    RUNIT_KIND_FINITE,
+    RUNIT_KIND_NOTFINITE,
+    RUNIT_KIND_FLAG,
+    RUNIT_KIND_NOFLAG,
+    RUNIT_KIND_STREQ,
+    RUNIT_KIND_MEMEQ,
+    RUNIT_KIND_MEMNEQ,
+    RUNIT_KIND_ZEROS,
+    RUNIT_KIND_NZEROS,
+    RUNIT_KIND_FAIL,
+    RUNIT_KIND_REPORT, /**< Not an assertion: a runit_report() call. */
+    RUNIT_KIND_BENCH,  /**< Not an assertion: a #RUNIT_BENCH loop. */
+    RUNIT_KIND_MAX_NS,
+    RUNIT_KIND_MAX_CYCLES,
+    RUNIT_KIND_FARRAY_DELTA,
+    RUNIT_KIND_DARRAY_DELTA,
+    RUNIT_KIND_ARRAY_EQ,
+    RUNIT_KIND_FULP,
+    RUNIT_KIND_DULP,
+    RUNIT_KIND_FARRAY_ULP,
+    RUNIT_KIND_DARRAY_ULP,
+    RUNIT_KIND_FCLOSE,
+    RUNIT_KIND_DCLOSE,
+    RUNIT_KIND_FREL,
+    RUNIT_KIND_DREL,
+    RUNIT_KIND_SLOWEST,   /**< Not an assertion: a line of runit_report_times(). */
+    RUNIT_KIND_TIMES,     /**< Not an assertion: a line of runit_report_times(). */
+    RUNIT_KIND_HISTOGRAM, /**< Not an assertion: a line of runit_report_times(). */
+    RUNIT_KIND_CRASH,     /**< A test case stopped by a signal, see runit_set_crash_recovery(). */
+    RUNIT_KIND_TIMEOUT,   /**< A test case stopped by runit_set_timeout() or runit_fail_timeout(). */
+    RUNIT_KIND_HARDFAULT, /**< A test case stopped by a Cortex-M fault, see runit_fail_fault(). */
+    /* Append new kinds here, tools/runit_detokenize.py relies on the values. */
+    RUNIT_KIND_COUNT
+} runit_kind_t;
+
+/**
+ * Constant description of the place where an assertion macro is written.
+ *
+ * One instance is emitted per assertion as a `static const` object, so a
+ * failing assertion passes a single pointer instead of its location
+ * as separate arguments.
+ *
+ * Where supported (see #RUNIT_HAVE_SITE_SECTION), all descriptors of the
+ * program are collected by the linker into the `runit_sites` section and can
+ * be enumerated with runit_sites_begin() and runit_sites_end() without
+ * running any test.
+ */
+typedef struct runit_site
+{
+    const char*  file;       /**< Source file, see #RUNIT_FILENAME. */
+    const char*  function;   /**< Enclosing function, thus the test case. */
+    const char*  expression; /**< Arguments of the macro as written. */
+    unsigned int line;       /**< Line number of the assertion. */
+    unsigned int kind;       /**< Macro that emitted it, a #runit_kind_t. */
+} runit_site_t;
+
+/**
+ * Set to 1 when the call-site descriptors are placed into the `runit_sites`
+ * linker section, which requires GCC or Clang producing ELF files.
+ *
+ * The linker defines the `__start_runit_sites` and `__stop_runit_sites`
+ * symbols around it. Linker scripts for bare-metal targets must place the
+ * section and provide the two symbols, see the STM32 example.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__ELF__)
+#    define RUNIT_HAVE_SITE_SECTION 1
+#    define RUNIT_SITE_ATTRIBUTES   __attribute__((section("runit_sites"), used, aligned(sizeof(void*))))
+#else
+#    define RUNIT_HAVE_SITE_SECTION 0
+#    define RUNIT_SITE_ATTRIBUTES
+#endif
+
+/**
+ * Tokenized output mode, enabled by defining `RUNIT_TOKENIZED` for the whole
+ * project (CMake option `RUNIT_TOKENIZED`).
+ *
+ * Instead of the text of the `FAIL`, `REPORT` and `BENCH` lines, runit emits
+ * a few bytes per line to the sink (see runit_set_sink()):
+ *
+ * | Bytes | Content                                            |
+ * |-------|----------------------------------------------------|
+ * | 1     | #RUNIT_TOKEN_MARKER                                |
+ * | 4     | token: index of the call site in `runit_sites`, LE |
+ * | 1     | amount of 32-bit arguments following               |
+ * | 4 * n | arguments, LE                                      |
+ *
+ * The arguments depend on the kind of the call site: passes and failures of
+ * a report; 7 values of #runit_bench_stats_t for the results of a benchmark,
+ * or 3 (baseline median, median, z-score) for its regression; measured value,
+ * budget, statistic and repetitions of a performance assertion; the offset of
+ * the first non-zero byte for runit_zeros(); the offset of the first
+ * difference, start and length of the window and 8 bytes of each section for
+ * runit_memeq(); index, both values and error (as 64-bit doubles) of the
+ * worst element of a floating point array (with the ULP distance instead of
+ * the error for the ULP arrays); index, element size and both values (64 bits
+ * each) of the first difference of an integer array; ULP distance and maximum
+ * (64 bits each) of a scalar ULP comparison; type and 64-bit value of both
+ * operands of a comparison such as runit_eq(), see #RUNIT_HAVE_VALUES; index
+ * and microseconds of a slow test case, or the amount of test cases and the
+ * sum and wall time (64-bit microseconds), or the 7 histogram buckets of
+ * runit_report_times(); index of the test case and signal number of a crash;
+ * index of the test case, elapsed and allowed milliseconds and whether the
+ * limit was the one of the whole run for a timeout; index of the test case,
+ * then the registers in the order of #runit_fault_t for a HardFault.
+ *
+ * `tools/runit_detokenize.py` rebuilds the text lines from the call-site
+ * table stored in the ELF file, copying any other byte of the stream as it is.
+ * Requires #RUNIT_HAVE_SITE_SECTION.
+ */
+#define RUNIT_TOKEN_MARKER (0xFFU)
+
+#if defined(RUNIT_TOKENIZED) && !RUNIT_HAVE_SITE_SECTION
+#    error "RUNIT_TOKENIZED requires the runit_sites section (GCC or Clang, ELF output)"
+#endif
+
+/**
+ * Emits a `static const` call-site descriptor with the given name for the
+ * macro at the current line.
+ */
+#define RUNIT_SITE_NAMED_(name, kind, text) \
+    static const runit_site_t name RUNIT_SITE_ATTRIBUTES = {RUNIT_SITE_FILE, __func__, text, __LINE__, kind}
+
+/**
+ * Emits the `static const` call-site descriptor named `runit_site_`
+ * for the macro at the current line.
+ */
+#define RUNIT_SITE_(kind, text) RUNIT_SITE_NAMED_(runit_site_, kind, text)
+
+/**
+ * First call-site descriptor of the whole program.
+ *
+ * Together with runit_sites_end() allows tools and test runners to iterate
+ * over all assertions of the program without executing them.
+ * Without #RUNIT_HAVE_SITE_SECTION both return NULL.
+ */
+const runit_site_t* runit_sites_begin(void);
+
+/**
+ * One past the last call-site descriptor of the whole program.
+ */
+const runit_site_t* runit_sites_end(void);
+
+/**
+ * Amount of call-site descriptors of the whole program, including the ones of
+ * runit_report() calls. Always 0 without #RUNIT_HAVE_SITE_SECTION.
+ */
+size_t runit_site_count(void);
+
+/**
+ * Reports a failed assertion and updates the failure counters.
+ *
+ * Called only by the assertion macros on their failure branch. Sends
+ * a single `FAIL` line with the location described by the given call site
+ * to the sink, see runit_set_sink().
+ * If the compiler could not shorten the path of the file at compile time,
+ * it is shortened here when `RUNIT_NO_FULL_PATH` is defined while compiling
+ * `runit.c`, so define it for the whole project.
+ *
+ * @param[in] site call-site descriptor of the failed assertion, not NULL.
+ */
+RUNIT_COLD void runit_report_failure(const runit_site_t* site);
+
+/**
+ * Sends the status line of runit_report() for the given call site to the
+ * sink, see runit_set_sink().
+ *
+ * @param[in] site call-site descriptor of the runit_report() call, not NULL.
+ */
+RUNIT_COLD void runit_report_at(const runit_site_t* site);
+
+/**
+ * Destination of everything runit prints.
+ *
+ * Receives one whole preformatted record per call: a complete `FAIL` or
+ * `REPORT` line including the trailing newline, or one binary record
+ * in #RUNIT_TOKENIZED mode. Records are not null-terminated.
+ *
+ * A sink can thus push each line to the transport (UART, RTT, socket...) with
+ * a single call, bypassing the buffering of `stdio.h`.
+ *
+ * @param[in] context pointer given to runit_set_sink() along with the sink.
+ * @param[in] record bytes of the record, not NULL.
+ * @param[in] length amount of bytes of the record.
+ */
+typedef void (*runit_sink_t)(void* context, const char* record, size_t length);
+
+/**
+ * Maximum length of a text record, longer `FAIL` or `REPORT` lines are
+ * truncated (but still end with a newline). Override at compile time.
+ */
+#ifndef RUNIT_RECORD_MAX
+#    define RUNIT_RECORD_MAX 256U
+#endif
+
+/**
+ * Sets the sink receiving all runit records from now on.
+ *
+ * The initial sink is runit_sink_stdout(), unless `RUNIT_SINK` is defined while
+ * compiling `runit.c`: then that function is used from the start, with
+ * `RUNIT_SINK_CONTEXT` (or NULL) as context. E.g. `-DRUNIT_SINK=my_uart_sink`.
+ *
+ * @param[in] sink function receiving the records, NULL restores
+ *            runit_sink_stdout().
+ * @param[in] context passed as it is to every call of the sink.
+ */
+void runit_set_sink(runit_sink_t sink, void* context);
+
+/**
+ * Built-in sink writing the records to `stdout` with `fwrite()`.
+ *
+ * Keeps the order with the output of `printf()` of the test suite itself.
+ * The context is ignored.
+ */
+void runit_sink_stdout(void* context, const char* record, size_t length);
+
+/**
+ * Set to 1 when the built-in sink runit_sink_fd() is available, which
+ * requires the POSIX `write()` function.
+ */
+#if defined(__unix__) || defined(__APPLE__) || defined(__NEWLIB__)
+#    define RUNIT_HAVE_SINK_FD 1
+#else
+#    define RUNIT_HAVE_SINK_FD 0
+#endif
+
+#if RUNIT_HAVE_SINK_FD
+/**
+ * Built-in sink writing each record with a single `write()` call to a file
+ * descriptor, without any buffering.
+ *
+ * The context is the file descriptor, set it with `(void*) (intptr_t) fd`.
+ * A write that fails, would block or makes no progress drops the rest of the
+ * record instead of retrying.
+ */
+void runit_sink_fd(void* context, const char* record, size_t length);
+#endif
+
+/**
+ * Capacity in bytes of the static buffer of runit_sink_ring().
+ * Override at compile time.
+ */
+#ifndef RUNIT_SINK_RING_SIZE
+#    define RUNIT_SINK_RING_SIZE 4096U
+#endif
+
+/**
+ * Built-in sink storing the records in a static ring buffer of
+ * #RUNIT_SINK_RING_SIZE bytes, to be read later with runit_sink_ring_read().
+ *
+ * A record not fitting into the free space is dropped as a whole and counted,
+ * see runit_sink_ring_dropped(). The context is ignored.
+ */
+void runit_sink_ring(void* context, const char* record, size_t length);
+
+/**
+ * Moves up to `max_length` bytes out of the buffer of runit_sink_ring().
+ *
+ * @param[out] dst destination of the bytes, not NULL.
+ * @param[in] max_length capacity of dst.
+ * @return the amount of bytes copied, 0 when the buffer is empty.
+ */
+size_t runit_sink_ring_read(char* dst, size_t max_length);
+
+/**
+ * Amount of records runit_sink_ring() dropped, as they did not fit.
+ */
+size_t runit_sink_ring_dropped(void);
+
+/**
+ * Capacity of the queue of deferred records, in records. Must be a power
+ * of 2. Override at compile time.
+ */
+#ifndef RUNIT_DEFERRED_CAPACITY
+#    define RUNIT_DEFERRED_CAPACITY 64U
+#endif
+
+/**
+ * Enables or disables the deferred output.
+ *
+ * When enabled, a failing assertion or runit_report() does not format
+ * anything nor wait for the sink: it only stores a compact record (a pointer
+ * to its call site and the counters of a report) into a static queue of
+ * #RUNIT_DEFERRED_CAPACITY records. Call runit_flush() later, e.g. from an
+ * idle hook, to format and send them to the sink. Useful for timing-sensitive
+ * tests on slow output links.
+ *
+ * The queue is lock-free for a single producer and a single consumer: the
+ * assertions of the test suite may run in one thread while runit_flush() is
+ * called from an interrupt or a second thread. Requires C11 atomics,
+ * otherwise it is safe on single-core targets only.
+ *
+ * Disabling the deferred output flushes the queue.
+ *
+ * @param[in] enabled non-zero to queue records, 0 to send them immediately.
+ */
+void runit_set_deferred(int enabled);
+
+/**
+ * Formats the queued records and sends them to the sink, in order.
+ *
+ * @return the amount of records sent.
+ */
+size_t runit_flush(void);
+
+/**
+ * Amount of records lost since the start, as the deferred queue was full.
+ *
+ * The assertion counters are always updated, even for lost records.
+ */
+size_t runit_deferred_overflows(void);
+
+/** Test case function: no arguments, no return value. */
+typedef void (*runit_test_fn_t)(void);
+
+/**
+ * Descriptor of a test case registered with #RUNIT_TEST.
+ *
+ * All descriptors of the program are collected by the linker into the
+ * `runit_tests` section and can be enumerated with runit_tests_begin() and
+ * runit_tests_end().
+ */
+typedef struct runit_test
+{
+    const char*     name;     /**< Name of the test case function. */
+    runit_test_fn_t function; /**< The test case itself. */
+    const char*     file;     /**< Source file, see #RUNIT_FILENAME. */
+    unsigned int    line;     /**< Line number of the definition. */
+} runit_test_t;
+
+#if RUNIT_HAVE_SITE_SECTION
+#    if defined(__has_attribute)
+#        if __has_attribute(retain)
+/* Survives --gc-sections even without a KEEP() in the linker script. */
+#            define RUNIT_RETAIN_ retain,
+#        endif
+#    endif
+#    ifndef RUNIT_RETAIN_
+#        define RUNIT_RETAIN_
+#    endif
+#    define RUNIT_TEST_ATTRIBUTES \
+        __attribute__((section("runit_tests"), used, RUNIT_RETAIN_ aligned(sizeof(void*))))
+
+/**
+ * Defines a test case and registers it for runit_run_all().
+ *
+ * Use it in place of the signature of the test case function, the body
+ * follows:
+ *
+ * ```
+ * RUNIT_TEST(test_sqrt_negative_values)
+ * {
+ *     runit_nan(sqrt(-1.0));
+ * }
+ * ```
+ *
+ * The function is `static`, the registration is a constant descriptor placed
+ * into the `runit_tests` section: no call list to maintain, no code generation,
+ * no heap. The descriptors are marked as used (and retained, where supported)
+ * so they are not discarded by `-ffunction-sections -fdata-sections
+ * -Wl,--gc-sections`. Linker scripts for bare-metal targets must place the
+ * section with `KEEP()` and provide the `__start_runit_tests` and
+ * `__stop_runit_tests` symbols, see the STM32 example.
+ *
+ * Requires #RUNIT_HAVE_SITE_SECTION. The order in which the test cases run is
+ * the order of the descriptors in the section, which is not guaranteed to be
+ * the source order: test cases should not depend on each other.
+ */
+#    define RUNIT_TEST(name)                                                                                          \
+        static void name(void);                                                                                       \
+        static const runit_test_t runit_test_##name RUNIT_TEST_ATTRIBUTES = {#name, name, RUNIT_SITE_FILE, __LINE__}; \
+        static void name(void)
+#endif
+
+/**
+ * First registered test case of the whole program.
+ *
+ * Without #RUNIT_HAVE_SITE_SECTION both runit_tests_begin() and
+ * runit_tests_end() return NULL.
+ */
+const runit_test_t* runit_tests_begin(void);
+
+/**
+ * One past the last registered test case of the whole program.
+ */
+const runit_test_t* runit_tests_end(void);
+
+/**
+ * Amount of test cases registered with #RUNIT_TEST in the whole program.
+ */
+size_t runit_test_count(void);
+
+/**
+ * Runs all test cases registered with #RUNIT_TEST, one after the other, or
+ * only those of the shard selected with runit_set_shard().
+ *
+ * A failing test case does not stop the other ones. Call runit_report()
+ * afterwards for the summary.
+ *
+ * @return the amount of test cases run.
+ */
+size_t runit_run_all(void);
+
+/**
+ * Same as runit_run_all(), skipping the test cases before @p first, e.g. to
+ * go on after the one that made a watchdog reset the target.
+ *
+ * @param[in] first position of the first test case to run, from runit_tests_begin().
+ * @return the amount of test cases run.
+ */
+size_t runit_run_from(size_t first);
+
+/** Returned by runit_current_test() between test cases. */
+#define RUNIT_NO_TEST ((size_t) -1)
+
+/**
+ * Position of the test case being run by runit_run_all(), runit_run_from() or
+ * runit_main(), from runit_tests_begin(); #RUNIT_NO_TEST otherwise.
+ *
+ * Meant as a progress marker for a watchdog: read it from a timer interrupt
+ * and keep it in memory that survives a reset, to know which test case hung.
+ */
+size_t runit_current_test(void);
+
+/** Arguments of the cause kept by runit_persist_cause(). */
+#define RUNIT_CAUSE_ARGS 7U
+
+/**
+ * Progress of runit_run_all() or runit_run_from() that survives a reset of
+ * the target, see runit_resume(). Only runit writes it.
+ */
+typedef struct runit_persistent
+{
+    uint32_t magic;
+    uint32_t test;     /**< Test case running, or the next one to run. */
+    uint32_t running;  /**< 1 while the test case runs. */
+    uint32_t passes;   /**< #runit_counter_assert_passes before it. */
+    uint32_t failures; /**< #runit_counter_assert_failures before it. */
+    uint32_t cause;    /**< #runit_kind_t noted by runit_persist_cause(), 0 if none. */
+    uint32_t argc;
+    uint32_t args[RUNIT_CAUSE_ARGS];
+    uint32_t crc; /**< CRC-32 of all the fields above. */
+} runit_persistent_t;
+
+/**
+ * Places a variable into the `.noinit` section, which the startup code of the
+ * target neither initializes nor zeroes, so it keeps its value over a reset.
+ * The linker script must provide that section, as in the STM32 example.
+ */
+#if defined(__GNUC__)
+#    define RUNIT_NOINIT __attribute__((section(".noinit")))
+#else
+#    define RUNIT_NOINIT
+#endif
+
+/**
+ * Goes on after a test case that crashed or hung the target until a reset,
+ * e.g. by a HardFault or a watchdog, instead of running it again and again.
+ *
+ * From then on, runit_run_all() and runit_run_from() keep the current test
+ * case and the counters in @p state, guarded by a magic number and a CRC, and
+ * clear it at the end of the run. At the next start, usually with @p state in
+ * #RUNIT_NOINIT memory, call runit_resume() before running the test cases:
+ * when the state is valid, the counters are restored and a test case that
+ * was running fails, printed with the cause noted by runit_persist_cause():
+ *
+ * ```
+ * CRASH | File: test.c:87 | Test case: test_dma_transfer | Signal: reset (0)
+ * ```
+ *
+ * ```
+ * static runit_persistent_t persistent RUNIT_NOINIT;
+ *
+ * runit_run_from(runit_resume(&persistent));
+ * ```
+ *
+ * @param[in] state memory that keeps its value over a reset, NULL to stop.
+ * @return the test case to go on with for runit_run_from(), 0 on a fresh
+ *         start; after a timeout of the whole run, the amount of test cases.
+ */
+size_t runit_resume(runit_persistent_t* state);
+
+/**
+ * Notes why the running test case will not finish, e.g. from a fault or
+ * watchdog handler, for the report of runit_resume() after the reset.
+ *
+ * The known causes are #RUNIT_KIND_CRASH with the signal number,
+ * #RUNIT_KIND_TIMEOUT with the elapsed time, the limit and whether it was the
+ * one of the whole run, as in runit_fail_timeout(), and #RUNIT_KIND_HARDFAULT
+ * with the registers of #runit_fault_t. Does nothing outside of a test case or
+ * without runit_resume().
+ *
+ * @param[in] kind record to print after the reset.
+ * @param[in] args its arguments after the test case, at most #RUNIT_CAUSE_ARGS.
+ * @param[in] argc amount of @p args.
+ */
+void runit_persist_cause(runit_kind_t kind, const uint32_t* args, size_t argc);
+
+/**
+ * Fails the test case at that position because it took too long, printing
+ * the elapsed time and the limit:
+ *
+ * ```
+ * TIMEOUT | File: test.c:87 | Test case: test_wait_for_ack | Elapsed: 1002 ms | Limit: 1000 ms
+ * ```
+ *
+ * runit_set_timeout() calls it on hosts; a target can call it after a
+ * watchdog reset, see runit_current_test().
+ *
+ * @param[in] index position of the test case, from runit_tests_begin().
+ * @param[in] elapsed_ms time the test case ran.
+ * @param[in] limit_ms time it was allowed to run.
+ */
+void runit_fail_timeout(size_t index, uint32_t elapsed_ms, uint32_t limit_ms);
+
+/**
+ * Registers of a Cortex-M fault: the ones stacked on exception entry, then the
+ * fault status and address registers of the System Control Block.
+ */
+typedef struct runit_fault
+{
+    uint32_t pc;    /**< Stacked program counter, usually the faulting instruction. */
+    uint32_t lr;    /**< Stacked link register: the caller of the faulting function. */
+    uint32_t xpsr;  /**< Stacked program status, with the exception number. */
+    uint32_t cfsr;  /**< Configurable Fault Status Register, `SCB->CFSR`. */
+    uint32_t hfsr;  /**< HardFault Status Register, `SCB->HFSR`. */
+    uint32_t mmfar; /**< MemManage Fault Address Register, valid with `CFSR.MMARVALID`. */
+    uint32_t bfar;  /**< BusFault Address Register, valid with `CFSR.BFARVALID`. */
+} runit_fault_t;
+
+/**
+ * Fails the test case being run because of a fault, from a fault handler:
+ *
+ * ```
+ * HARDFAULT | File: test.c:87 | Test case: test_dma_transfer | PC: 0x08001A2C | LR: 0x08001A11 | xPSR: 0x21000000 | CFSR: 0x00008200 | HFSR: 0x40000000 | MMFAR: 0xE000EDF8 | BFAR: 0x20010000
+ * ```
+ *
+ * After runit_resume(), the registers are only noted with
+ * runit_persist_cause() and the line is printed by runit_resume() after the
+ * reset, as the run goes on with the next test case. Otherwise the line is
+ * printed at once, for a target that halts.
+ *
+ * The built-in handler of #RUNIT_HARDFAULT_HANDLER calls it on ARMv7-M and
+ * ARMv8-M cores; it is portable anyway, e.g. for other fault handlers or to
+ * test the output on a host.
+ *
+ * @param[in] fault registers captured by the handler.
+ * @return 1 when noted: reset the target to go on; 0 when printed: halt.
+ */
+int runit_fail_fault(const runit_fault_t* fault);
+
+/**
+ * Cortex-M target backend, enabled by defining `RUNIT_HARDFAULT_HANDLER` for
+ * the whole project (CMake option `RUNIT_HARDFAULT_HANDLER`): runit defines
+ * `HardFault_Handler()`, replacing the weak alias of the startup code. It
+ * captures #runit_fault_t from the stack in use at the fault and passes it to
+ * runit_fail_fault(), then resets the target through `SCB->AIRCR` or halts in
+ * an endless loop. ARMv7-M and ARMv8-M cores only (Cortex-M3 and above): the
+ * fault status registers do not exist on ARMv6-M.
+ */
+#if defined(RUNIT_HARDFAULT_HANDLER)
+void HardFault_Handler(void);
+#endif
+
+/**
+ * Test cases whose duration runit_run_all() and runit_main() keep for
+ * runit_test_time() and the slowest ones of runit_report_times(). The sum and
+ * the histogram include all test cases anyway.
+ */
+#ifndef RUNIT_TIMES_CAPACITY
+#    define RUNIT_TIMES_CAPACITY 256U
+#endif
+
+/** Amount of slowest test cases listed by runit_report_times(). */
+#ifndef RUNIT_SLOWEST
+#    define RUNIT_SLOWEST 10U
+#endif
+
+/** Buckets of the histogram of runit_report_times(), one per decade from 0.1 ms. */
+#define RUNIT_HISTOGRAM_BUCKETS 7U
+
+/**
+ * Duration of a test case in the last runit_run_all() or runit_main(), in
+ * microseconds of runit_clock_ns(): the runner reads the clock once before
+ * and once after each test case.
+ *
+ * @param[in] index position of the test case from runit_tests_begin().
+ * @return 0 if it did not run or is beyond #RUNIT_TIMES_CAPACITY.
+ */
+uint32_t runit_test_time(size_t index);
+
+/**
+ * Sends the timing of the last runit_run_all() or runit_main() to the sink:
+ * the #RUNIT_SLOWEST slowest test cases, the sum of all of them with the wall
+ * time of the whole run, and how many took less than 0.1 ms, 1 ms ... 10 s:
+ *
+ * ```
+ * SLOWEST | File: test.c:87 | Test case: test_flash_erase | Time: 412.310 ms
+ * TIMES | Test cases: 120 | Sum: 530.402 ms | Wall: 131.977 ms
+ * HISTOGRAM | <0.1 ms: 97 | <1 ms: 15 | <10 ms: 6 | <100 ms: 1 | <1 s: 1 | <10 s: 0 | >=10 s: 0
+ * ```
+ *
+ * runit_main() calls it before runit_report().
+ */
+void runit_report_times(void);
+
+/** Most shards that can be balanced by duration, see runit_set_shard(). */
+#ifndef RUNIT_SHARD_MAX
+#    define RUNIT_SHARD_MAX 64U
+#endif
+
+/**
+ * Restricts runit_run_all() and runit_main() to one shard of the registered
+ * test cases, to split a suite over several machines. Each test case belongs
+ * to exactly one of the @p count shards, the same one on every machine
+ * running the same executable.
+ *
+ * Without @p times the test cases are dealt out in registration order: shard
+ * 0 gets the first one, shard 1 the second one and so on. With @p times, a
+ * file of `name microseconds` lines as written by runit_save_times(), the
+ * longest test cases are placed first, each one into the shard with the
+ * least total time so far, so all shards take about as long. Test cases
+ * missing from the file weigh as much as the average of the others. Beyond
+ * #RUNIT_SHARD_MAX shards or #RUNIT_TIMES_CAPACITY test cases, the remaining
+ * ones are dealt out in order, see runit_shard_unplanned().
+ *
+ * @param[in] index shard to run, from 0 to @p count - 1.
+ * @param[in] count amount of shards, 1 runs all test cases.
+ * @param[in] times file with the durations of an earlier run, or NULL.
+ * @return 0 on success, -1 if @p index is not below @p count.
+ */
+int runit_set_shard(size_t index, size_t count, const char* times);
+
+/**
+ * Test cases beyond #RUNIT_TIMES_CAPACITY that the last runit_set_shard()
+ * with @p times dealt out in order instead of balancing them; raise the
+ * capacity to balance them too. runit_main() prints it on `stderr`.
+ *
+ * @return 0 if all test cases are balanced or the shards are not.
+ */
+size_t runit_shard_unplanned(void);
+
+/**
+ * Whether the test case belongs to the shard selected with runit_set_shard(),
+ * always 1 without shards.
+ *
+ * @param[in] index position of the test case from runit_tests_begin().
+ */
+int runit_in_shard(size_t index);
+
+/**
+ * Writes the durations of the test cases run by the last runit_run_all() or
+ * runit_main() into a file for runit_set_shard(), one `name microseconds`
+ * line each. The files of all shards can simply be concatenated.
+ *
+ * @param[in] path file to overwrite.
+ * @return 0 on success, -1 if the file cannot be written.
+ */
+int runit_save_times(const char* path);
+
+/**
+ * Set to 1 when runit_main() can run the test cases in parallel worker
+ * processes, which requires `fork()`, `mmap()` and C11 atomics.
+ */
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__STDC_NO_ATOMICS__)
+#    define RUNIT_HAVE_PARALLEL 1
+#else
+#    define RUNIT_HAVE_PARALLEL 0
+#endif
+
+/**
+ * Set to 1 when runit_set_crash_recovery() can survive crashing test cases,
+ * which requires POSIX signals with `sigsetjmp()` and `sigaltstack()`.
+ */
+#if defined(__unix__) || defined(__APPLE__)
+#    define RUNIT_HAVE_CRASH_RECOVERY 1
+#else
+#    define RUNIT_HAVE_CRASH_RECOVERY 0
+#endif
+
+/** Size of the static stack the crash signals are handled on. */
+#ifndef RUNIT_CRASH_STACK_SIZE
+#    define RUNIT_CRASH_STACK_SIZE 65536U
+#endif
+
+/**
+ * Lets runit_run_all() and runit_main() go on with the next test case when
+ * one crashes with `SIGSEGV`, `SIGBUS`, `SIGFPE` or `SIGILL`, instead of
+ * losing the results of all the following ones. The crash counts as a
+ * failure and is printed with the signal:
+ *
+ * ```
+ * CRASH | File: test.c:87 | Test case: test_parse_header | Signal: SIGSEGV (11)
+ * ```
+ *
+ * The handlers run on a static stack of #RUNIT_CRASH_STACK_SIZE bytes, so
+ * even a stack overflow is caught, and jump back into the runner with
+ * `siglongjmp()`: running a test case costs one more `sigsetjmp()`, without
+ * any system call. Whatever the test case did not clean up stays so: memory,
+ * locks, open files. Crashes in other threads or outside of the test cases
+ * go to the previous handlers, then end the process.
+ *
+ * That stack is installed for the thread that first calls
+ * runit_set_crash_recovery() or runit_set_timeout(), as a thread has its own
+ * alternate signal stack: run the test cases from that thread, a stack
+ * overflow in any other thread is not caught.
+ *
+ * @param[in] enable 1 installs the signal handlers, 0 restores the previous ones.
+ * @return 0 on success, -1 without #RUNIT_HAVE_CRASH_RECOVERY or if the
+ *         handlers cannot be installed.
+ */
+int runit_set_crash_recovery(int enable);
+
+/**
+ * Stops the test cases of runit_run_all() and runit_main() that take longer
+ * than @p test_ms, and the whole run after @p total_ms: the stopped test case
+ * fails with runit_fail_timeout() and, after the whole run, the remaining
+ * ones do not run at all:
+ *
+ * ```
+ * TIMEOUT | File: test.c:90 | Test case: test_flash_erase | Elapsed: 60000 ms | Limit: 60000 ms for all test cases
+ * ```
+ *
+ * A timer of the process sends `SIGALRM`, which jumps out of the test case
+ * the same way as runit_set_crash_recovery(), also out of a blocking call or
+ * a deadlock; whatever the test case held stays so. Other threads must block
+ * `SIGALRM`. Requires #RUNIT_HAVE_CRASH_RECOVERY; in parallel mode each
+ * worker keeps the time of its own test cases, and only the first worker to
+ * reach the end of the whole run reports it.
+ *
+ * @param[in] test_ms limit of each test case in milliseconds, 0 for none.
+ * @param[in] total_ms limit of the whole run in milliseconds, 0 for none.
+ * @return 0 on success, -1 if timeouts are not available.
+ */
+int runit_set_timeout(uint32_t test_ms, uint32_t total_ms);
+
+/**
+ * Complete test runner for host executables: runs all test cases registered
+ * with #RUNIT_TEST, prints the runit_report() line and provides the exit code.
+ *
+ * ```
+ * int main(int argc, char** argv)
+ * {
+ *     return runit_main(argc, argv);
+ * }
+ * ```
+ *
+ * Options:
+ * - `-j N`: spreads the test cases over N worker processes, 0 means one per
+ *   online CPU. The workers take the next test case from a shared-memory queue
+ *   as soon as they are done with the previous one, so long and short test
+ *   cases balance out. Their assertion counters are added to
+ *   #runit_counter_assert_passes and #runit_counter_assert_failures of the
+ *   calling process; a worker that crashes counts as one more failure.
+ *   Requires #RUNIT_HAVE_PARALLEL, otherwise the test cases run serially.
+ * - `--shard I/N`: runs only the shard I (from 0) of N, see runit_set_shard().
+ *   The environment variables `RUNIT_SHARD_INDEX` and `RUNIT_SHARD_COUNT` do
+ *   the same, e.g. through the `ENVIRONMENT` property of a CTest test.
+ *   `RUNIT_SHARD_TIMES` names the file of durations that balances the shards;
+ *   with `RUNIT_SHARD_TIMES_UPDATE=1` that file is written instead, with
+ *   runit_save_times() after the run.
+ * - `--catch-crashes`: goes on after a crashing test case, see
+ *   runit_set_crash_recovery().
+ * - `--timeout MS`, `--total-timeout MS`: stops a test case or the whole run
+ *   after that many milliseconds, see runit_set_timeout().
+ *
+ * In parallel mode the test cases must not depend on each other nor on state
+ * changed by other test cases. Records sent to the default sink are written
+ * with one `write()` each, so lines of different workers do not mix; other
+ * sinks run in the worker processes.
+ *
+ * @return 0 when all assertions passed, 1 on failures, 2 on invalid options.
+ */
+int runit_main(int argc, char** argv);
+
+/**
+ * Source of time for #RUNIT_BENCH: a free-running counter, e.g. nanoseconds
+ * of a monotonic clock or CPU cycles.
+ */
+typedef uint64_t (*runit_clock_t)(void);
+
+/**
+ * Set to 1 when the built-in clock runit_clock_monotonic() is available, which
+ * requires the POSIX `clock_gettime()` function.
+ */
+#if defined(__unix__) || defined(__APPLE__)
+#    define RUNIT_HAVE_CLOCK_MONOTONIC 1
+#else
+#    define RUNIT_HAVE_CLOCK_MONOTONIC 0
+#endif
+
+#if RUNIT_HAVE_CLOCK_MONOTONIC
+/**
+ * Built-in clock: nanoseconds of `CLOCK_MONOTONIC`. The default one.
+ */
+uint64_t runit_clock_monotonic(void);
+#endif
+
+/**
+ * Set to 1 when the built-in clock runit_clock_rdtsc() is available, which
+ * requires an x86 processor and GCC or Clang.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#    define RUNIT_HAVE_CLOCK_RDTSC 1
+#else
+#    define RUNIT_HAVE_CLOCK_RDTSC 0
+#endif
+
+#if RUNIT_HAVE_CLOCK_RDTSC
+/**
+ * Built-in clock: the time-stamp counter of x86 processors, in reference
+ * cycles. Cheaper to read than runit_clock_monotonic(); not serializing, so
+ * for very short measurements the results of both may differ a bit.
+ */
+uint64_t runit_clock_rdtsc(void);
+#endif
+
+/**
+ * Cortex-M target backend, enabled by defining `RUNIT_CLOCK_DWT` for the whole
+ * project (CMake option `RUNIT_CLOCK_DWT`): the default clock becomes
+ * runit_clock_dwt(), in CPU cycles.
+ */
+#if defined(RUNIT_CLOCK_DWT)
+/**
+ * Built-in clock: the `DWT->CYCCNT` cycle counter of ARMv7-M and ARMv8-M
+ * cores (Cortex-M3 and above), extended to 64 bits.
+ *
+ * The first call enables the trace unit and the counter. The extension
+ * requires reading the clock at least once per wraparound of the 32-bit
+ * counter, e.g. every 59 s at 72 MHz.
+ */
+uint64_t runit_clock_dwt(void);
+#endif
+
+/**
+ * Extends a free-running 32-bit counter, e.g. a cycle counter, to 64 bits.
+ *
+ * Detects a wraparound when the counter is lower than at the previous call,
+ * so it must be called at least once per period of the counter.
+ *
+ * @param[in,out] extended the previous result, start from 0.
+ * @param[in] counter current value of the 32-bit counter.
+ * @return the extended value, also stored into `extended`.
+ */
+uint64_t runit_clock_extend32(uint64_t* extended, uint32_t counter);
+
+/**
+ * Built-in clock: nanoseconds of the standard `clock()`, processor time with
+ * the resolution of `CLOCKS_PER_SEC`. The default one where
+ * runit_clock_monotonic() is not available.
+ */
+uint64_t runit_clock_std(void);
+
+/**
+ * Changes the clock of the benchmarks.
+ *
+ * Where the built-in clocks are not precise enough, e.g. on microcontrollers,
+ * provide a cycle counter instead:
+ *
+ * ```
+ * static uint64_t dwt_cycles(void)
+ * {
+ *     return DWT->CYCCNT;
+ * }
+ *
+ * runit_set_clock(dwt_cycles, "cycles");
+ * ```
+ *
+ * The clock can also be chosen at compile time by defining `RUNIT_CLOCK` as
+ * the name of such a function and `RUNIT_CLOCK_UNIT` as a string.
+ *
+ * @param[in] clock the new clock; NULL restores the default one.
+ * @param[in] unit name of the unit of the clock, printed in the results.
+ */
+void runit_set_clock(runit_clock_t clock, const char* unit);
+
+/**
+ * Current value of the clock, see runit_set_clock().
+ */
+uint64_t runit_clock_now(void);
+
+/**
+ * Cost of reading the clock, in its unit: the smallest difference between
+ * two consecutive runit_clock_now() calls over a few tries. Measured at the
+ * first call and after each runit_set_clock().
+ *
+ * #RUNIT_BENCH subtracts it from each sample.
+ */
+uint64_t runit_clock_overhead(void);
+
+/** Default amount of samples collected by #RUNIT_BENCH. */
+#ifndef RUNIT_BENCH_SAMPLES
+#    define RUNIT_BENCH_SAMPLES 100U
+#endif
+
+/**
+ * Minimum duration of each sample of #RUNIT_BENCH, in clock units. The amount
+ * of iterations per sample is doubled until a sample lasts at least this long,
+ * so the reading of the clock costs little in comparison.
+ */
+#ifndef RUNIT_BENCH_MIN_TICKS
+#    define RUNIT_BENCH_MIN_TICKS 100000U
+#endif
+
+/** Samples run and discarded by #RUNIT_BENCH before the measured ones. */
+#ifndef RUNIT_BENCH_WARMUP
+#    define RUNIT_BENCH_WARMUP 3U
+#endif
+
+/**
+ * Results of a benchmark. The times are per iteration, in hundredths of the
+ * clock unit, saturated to `UINT32_MAX`.
+ */
+typedef struct runit_bench_stats
+{
+    uint32_t samples;    /**< Amount of samples. */
+    uint32_t iterations; /**< Iterations per sample. */
+    uint32_t min;        /**< Fastest sample. */
+    uint32_t median;     /**< Middle sample. */
+    uint32_t mean;       /**< Arithmetic mean. */
+    uint32_t p99;        /**< 99th percentile, nearest rank. */
+    uint32_t stddev;     /**< Sample standard deviation. */
+} runit_bench_stats_t;
+
+/** State of a running #RUNIT_BENCH loop. */
+typedef struct runit_bench
+{
+    const runit_site_t* site;
+    uint64_t*           samples;   /**< Clock units per sample. */
+    size_t              capacity;  /**< Samples to collect. */
+    size_t              count;     /**< Samples collected. */
+    uint64_t            start;     /**< Clock at the start of the sample. */
+    uint32_t            batch;     /**< Iterations per sample. */
+    uint32_t            remaining; /**< Iterations left in the sample. */
+    uint32_t            warmup;    /**< Samples left to discard. */
+    uint32_t            state;
+} runit_bench_t;
+
+/**
+ * Benchmarks the block following it: a loop running the block many times.
+ *
+ * ```
+ * RUNIT_BENCH(memcmp_256)
+ * {
+ *     RUNIT_BENCH_KEEP(memcmp(a, b, 256));
+ * }
+ * ```
+ *
+ * First doubles the amount of iterations per sample until one sample lasts
+ * at least #RUNIT_BENCH_MIN_TICKS, then runs #RUNIT_BENCH_WARMUP samples
+ * for warm-up and finally measures #RUNIT_BENCH_SAMPLES samples with the
+ * clock of runit_set_clock(). Sends one line with minimum, median, mean,
+ * 99th percentile and standard deviation per iteration to the sink:
+ *
+ * ```
+ * BENCH | File: test.c:12 | Test case: bench_compare | Name: memcmp_256 | Samples: 100 x 65536 | Min: 4.81 | Median: 4.86 | Mean: 4.90 | P99: 5.40 | Stddev: 0.11 | Unit: ns
+ * ```
+ *
+ * The samples are kept in a static buffer, not thread-safe: use
+ * #RUNIT_BENCH_INTO to provide one. The name must be a valid identifier,
+ * unique within the enclosing function. Do not leave the block with `break`,
+ * `return` or runit assertions, otherwise no result is reported.
+ */
+#define RUNIT_BENCH(name) RUNIT_BENCH_INTO(name, NULL, 0U)
+
+/**
+ * Same as #RUNIT_BENCH, with the samples kept in the given buffer of
+ * `uint64_t`; the amount of samples is its capacity.
+ *
+ * With GCC and Clang it is a single statement, e.g. the body of an `if`:
+ * the call site is declared in a statement expression and handed over by a
+ * loop that runs once. Other compilers declare it before the loop, so put
+ * the benchmark into braces there.
+ */
+#if defined(__GNUC__)
+#    define RUNIT_BENCH_INTO(name, buffer, capacity)                                                  \
+        for (const runit_site_t* runit_bench_site_ = __extension__({                                  \
+                 RUNIT_SITE_NAMED_(runit_bench_site_##name, RUNIT_KIND_BENCH, #name);                 \
+                 &runit_bench_site_##name;                                                            \
+             });                                                                                      \
+             runit_bench_site_ != NULL;                                                               \
+             runit_bench_site_ = NULL)                                                                \
+            for (runit_bench_t runit_bench_ = runit_bench_begin(runit_bench_site_, buffer, capacity); \
+                 runit_bench_.remaining-- != 0U || runit_bench_next(&runit_bench_);)
+#else
+#    define RUNIT_BENCH_INTO(name, buffer, capacity)                                                     \
+        RUNIT_SITE_NAMED_(runit_bench_site_##name, RUNIT_KIND_BENCH, #name);                             \
+        for (runit_bench_t runit_bench_ = runit_bench_begin(&runit_bench_site_##name, buffer, capacity); \
+             runit_bench_.remaining-- != 0U || runit_bench_next(&runit_bench_);)
+#endif
+
+/**
+ * Prevents the compiler from removing the computation of an unused value in
+ * a benchmark.
+ */
+#if defined(__GNUC__)
+#    define RUNIT_BENCH_KEEP(value) __asm__ volatile("" : : "g"(value) : "memory")
+#else
+#    define RUNIT_BENCH_KEEP(value)                  \
+        do                                           \
+        {                                            \
+            volatile uint64_t runit_kept_ = (value); \
+            (void) runit_kept_;                      \
+        } while (0)
+#endif
+
+/**
+ * Starts a #RUNIT_BENCH loop.
+ *
+ * @param[in] site descriptor of the benchmark, not NULL.
+ * @param[in] samples buffer of the samples, NULL for the static one.
+ * @param[in] capacity amount of samples in the buffer.
+ */
+runit_bench_t runit_bench_begin(const runit_site_t* site, uint64_t* samples, size_t capacity);
+
+/**
+ * Ends a sample of a #RUNIT_BENCH loop and starts the next one; after the
+ * last one reports the results.
+ *
+ * @return non-zero while the loop must go on.
+ */
+int runit_bench_next(runit_bench_t* bench);
+
+/**
+ * Computes the statistics of a benchmark from its samples.
+ *
+ * @param[in,out] samples clock units per sample, sorted by this function.
+ * @param[in] count amount of samples, at least 1.
+ * @param[in] iterations iterations per sample, at least 1.
+ * @param[out] stats results.
+ */
+void runit_bench_statistics(uint64_t* samples, size_t count, uint32_t iterations, runit_bench_stats_t* stats);
+
+/**
+ * Minimum slowdown of the median, in percent, that counts as a regression
+ * against the baseline, see runit_bench_set_baseline().
+ */
+#ifndef RUNIT_BENCH_THRESHOLD_PERCENT
+#    define RUNIT_BENCH_THRESHOLD_PERCENT 10U
+#endif
+
+/**
+ * Minimum z-score of the Mann-Whitney U test that counts as a regression
+ * against the baseline. The default is the one-sided 1% significance level.
+ */
+#ifndef RUNIT_BENCH_Z_CRITICAL
+#    define RUNIT_BENCH_Z_CRITICAL 2.326
+#endif
+
+/**
+ * Enables the regression gate of the benchmarks against a baseline file.
+ *
+ * With `update` set, every #RUNIT_BENCH of the program writes its samples into
+ * the file, which is emptied first. Otherwise every #RUNIT_BENCH with an
+ * entry in the file compares its samples with it, see runit_bench_compare():
+ * a regression is an assertion failure with a `FAIL` line at the benchmark,
+ * no regression is an assertion pass. Benchmarks without an entry are not
+ * checked.
+ *
+ * The file is plain text, one line per benchmark: the enclosing function and
+ * the name separated by `/`, the amount of samples, then the sorted times per
+ * iteration in hundredths of the clock unit. Only up to #RUNIT_BENCH_SAMPLES
+ * of them are read back.
+ *
+ * Without calling this function, the environment variable `RUNIT_BASELINE`
+ * provides the path of the file, checked at the first benchmark; with
+ * `RUNIT_BASELINE_UPDATE` set to 1 the file is updated. So a CI pipeline
+ * can gate the existing test executables without changing them.
+ *
+ * @param[in] path baseline file, NULL disables the gate.
+ * @param[in] update non-zero to write the file instead of comparing.
+ */
+void runit_bench_set_baseline(const char* path, int update);
+
+/** Result of runit_bench_compare(). */
+typedef struct runit_bench_comparison
+{
+    uint64_t baseline_median; /**< Median of the baseline samples. */
+    uint64_t median;          /**< Median of the current samples. */
+    double   z;               /**< Positive when the current ones are slower. */
+} runit_bench_comparison_t;
+
+/**
+ * Noise-aware comparison of benchmark samples: a regression requires both a
+ * slower median by at least #RUNIT_BENCH_THRESHOLD_PERCENT and a one-sided
+ * Mann-Whitney U test (normal approximation) reaching
+ * #RUNIT_BENCH_Z_CRITICAL, i.e. the current samples being larger than the
+ * baseline ones is unlikely to be noise.
+ *
+ * @param[in] baseline baseline samples, sorted in ascending order.
+ * @param[in] baseline_count amount of baseline samples, at least 1.
+ * @param[in] current current samples, same unit, sorted in ascending order.
+ * @param[in] current_count amount of current samples, at least 1.
+ * @param[out] comparison medians and z-score, may be NULL.
+ * @return non-zero on a regression.
+ */
+int runit_bench_compare(const uint64_t*           baseline,
+                        size_t                    baseline_count,
+                        const uint64_t*           current,
+                        size_t                    current_count,
+                        runit_bench_comparison_t* comparison);
+
+/**
+ * Set to 1 when a cycle counter is available for runit_max_cycles(): the DWT
+ * one with #RUNIT_CLOCK_DWT or the x86 time-stamp counter.
+ */
+#if defined(RUNIT_CLOCK_DWT) || RUNIT_HAVE_CLOCK_RDTSC
+#    define RUNIT_HAVE_CLOCK_CYCLES 1
+#else
+#    define RUNIT_HAVE_CLOCK_CYCLES 0
+#endif
+
+/**
+ * Clock of runit_max_ns(), in nanoseconds, independent of runit_set_clock():
+ * runit_clock_monotonic() where available; with #RUNIT_CLOCK_DWT the cycle
+ * counter converted with the core frequency `RUNIT_CPU_HZ`, which must then
+ * be defined (CMake cache variable `RUNIT_CPU_HZ`), or runit.c does not
+ * compile; otherwise runit_clock_std().
+ */
+uint64_t runit_clock_ns(void);
+
+#if RUNIT_HAVE_CLOCK_CYCLES
+/**
+ * Clock of runit_max_cycles(), in CPU cycles: runit_clock_dwt() with
+ * #RUNIT_CLOCK_DWT, otherwise runit_clock_rdtsc().
+ */
+uint64_t runit_clock_cycles(void);
+#endif
+
+/** Maximum amount of timed repetitions of a performance assertion. */
+#ifndef RUNIT_TIMING_SAMPLES
+#    define RUNIT_TIMING_SAMPLES 32U
+#endif
+
+/** Statistic of the repetitions compared to the budget of a performance assertion. */
+typedef enum runit_statistic
+{
+    RUNIT_MIN,    /**< Fastest repetition, the least noisy one. */
+    RUNIT_MEDIAN, /**< Middle repetition. */
+    RUNIT_P95,    /**< 95th percentile, nearest rank. */
+} runit_statistic_t;
+
+/** State of a performance assertion, see runit_max_ns(). */
+typedef struct runit_timing
+{
+    runit_clock_t clock;
+    uint64_t      start;     /**< Clock at the start of the repetition. */
+    uint64_t      overhead;  /**< Of reading the clock. */
+    uint64_t      value;     /**< The statistic, once done. */
+    uint32_t      repeats;   /**< Repetitions to run. */
+    uint32_t      count;     /**< Repetitions done. */
+    uint32_t      statistic; /**< A #runit_statistic_t. */
+} runit_timing_t;
+
+/**
+ * Prepares a performance assertion.
+ *
+ * @param[out] timing state to initialize.
+ * @param[in] clock runit_clock_ns() or runit_clock_cycles().
+ * @param[in] statistic a #runit_statistic_t.
+ * @param[in] repeats repetitions, between 1 and #RUNIT_TIMING_SAMPLES.
+ */
+void runit_timing_begin(runit_timing_t* timing, runit_clock_t clock, runit_statistic_t statistic, unsigned long repeats);
+
+/**
+ * Ends a repetition of a performance assertion; after the last one computes
+ * the statistic into `timing->value`.
+ *
+ * @return non-zero while more repetitions must run.
+ */
+int runit_timing_next(runit_timing_t* timing);
+
+/**
+ * Reports a performance assertion over budget and updates the failure
+ * counters.
+ *
+ * @param[in] site call-site descriptor of the assertion, not NULL.
+ * @param[in] timing the measurement.
+ * @param[in] budget the exceeded budget.
+ */
+RUNIT_COLD void runit_report_timing_failure(const runit_site_t* site, const runit_timing_t* timing, uint64_t budget);
+
+/**
+ * Finds the first non-zero byte of a memory section.
+ *
+ * Scans whole machine words, or SSE2, AVX2 or NEON vectors when the compiler
+ * targets them, and only looks at single bytes at the edges.
+ *
+ * @param[in] data start of the memory section.
+ * @param[in] length of the memory section in bytes.
+ * @return offset of the first non-zero byte, `length` if all bytes are zero.
  */
-#define RUNIT_FLOAT_EQ_ABSTOL (1e-5f)
+size_t runit_nonzero_offset(const void* data, size_t length);
 
 /**
- * Absolute tolerance when comparing two double-precision floating point
- * value for approximate-equality using runit_dapprox().
+ * Reports a runit_zeros() failure and updates the failure counters.
  *
- * If the difference between the two double values is bigger than this
- * tolerance, the assertion fails.
+ * @param[in] site call-site descriptor of the assertion, not NULL.
+ * @param[in] offset of the first non-zero byte.
  */
-#define RUNIT_DOUBLE_EQ_ABSTOL (1e-8)
+RUNIT_COLD void runit_report_zeros_failure(const runit_site_t* site, size_t offset);
+
+/**
+ * Finds the first differing byte of two memory sections.
+ *
+ * Compares whole machine words, or SSE2, AVX2 or NEON vectors when the
+ * compiler targets them, as runit_nonzero_offset().
+ *
+ * @param[in] a start of the first memory section.
+ * @param[in] b start of the second memory section.
+ * @param[in] length of both memory sections in bytes.
+ * @return offset of the first differing byte, `length` if they are equal.
+ */
+size_t runit_mismatch_offset(const void* a, const void* b, size_t length);
+
+/**
+ * Reports a runit_memeq() failure with the offset of the first difference and
+ * the bytes around it, and updates the failure counters.
+ *
+ * @param[in] site call-site descriptor of the assertion, not NULL.
+ * @param[in] a start of the first memory section.
+ * @param[in] b start of the second memory section.
+ * @param[in] length of both memory sections in bytes.
+ */
+RUNIT_COLD void runit_report_memeq_failure(const runit_site_t* site, const void* a, const void* b, size_t length);
+
+/**
+ * Verifies that all elements of two single-precision arrays are within a
+ * tolerance, SIMD-vectorized where available.
+ *
+ * @param[in] a first array.
+ * @param[in] b second array.
+ * @param[in] count elements in each array.
+ * @param[in] delta absolute tolerance, its sign is ignored.
+ * @return non-zero if no element differs by more than `delta` or is NaN.
+ */
+int runit_farray_within(const float* a, const float* b, size_t count, float delta);
+
+/** Same as runit_farray_within() for double-precision arrays. */
+int runit_darray_within(const double* a, const double* b, size_t count, double delta);
+
+/**
+ * Reports a runit_farray_delta() failure with the element having the largest
+ * error (the first NaN, if any) and updates the failure counters.
+ *
+ * @param[in] site call-site descriptor of the assertion, not NULL.
+ * @param[in] a first array.
+ * @param[in] b second array.
+ * @param[in] count elements in each array.
+ */
+RUNIT_COLD void runit_report_farray_failure(const runit_site_t* site, const float* a, const float* b, size_t count);
+
+/** Same as runit_report_farray_failure() for runit_darray_delta(). */
+RUNIT_COLD void runit_report_darray_failure(const runit_site_t* site, const double* a, const double* b, size_t count);
+
+/**
+ * Reports a runit_array_eq() failure with the first differing element and
+ * updates the failure counters.
+ *
+ * @param[in] site call-site descriptor of the assertion, not NULL.
+ * @param[in] a first array.
+ * @param[in] b second array.
+ * @param[in] count elements in each array.
+ * @param[in] size of one element in bytes, shown up to 8.
+ */
+RUNIT_COLD void runit_report_array_failure(const runit_site_t* site,
+                                           const void*         a,
+                                           const void*         b,
+                                           size_t              count,
+                                           size_t              size);
+
+/**
+ * Distance of two floats in units in the last place: how many representable
+ * floats lie between them, plus one.
+ *
+ * Computed on the bit patterns, so it is the same for values around 1e-30 or
+ * 1e30. `+0.0f` and `-0.0f` are at distance 0; a NaN is at the largest
+ * distance from anything.
+ */
+uint32_t runit_fulp_distance(float a, float b);
+
+/** Same as runit_fulp_distance() for doubles. */
+uint64_t runit_dulp_distance(double a, double b);
+
+/**
+ * Verifies that all elements of two single-precision arrays are within a
+ * distance in units in the last place, as runit_fulp_distance(), in a loop
+ * that compilers vectorize.
+ *
+ * @return non-zero if no element is farther than `maxulps` or NaN.
+ */
+int runit_farray_ulp_within(const float* a, const float* b, size_t count, uint32_t maxulps);
+
+/** Same as runit_farray_ulp_within() for double-precision arrays. */
+int runit_darray_ulp_within(const double* a, const double* b, size_t count, uint64_t maxulps);
+
+/**
+ * Verifies that two floats are equal or within the larger of an absolute
+ * tolerance and a tolerance relative to the larger magnitude of the two.
+ *
+ * @return non-zero if `|a - b| <= max(abstol, reltol * max(|a|, |b|))`.
+ */
+int runit_fclose_within(float a, float b, float abstol, float reltol);
+
+/** Same as runit_fclose_within() for doubles. */
+int runit_dclose_within(double a, double b, double abstol, double reltol);
+
+/**
+ * Reports a runit_fulp() or runit_dulp() failure with the ULP distance and
+ * updates the failure counters.
+ *
+ * @param[in] site call-site descriptor of the assertion, not NULL.
+ * @param[in] distance the exceeding ULP distance.
+ * @param[in] maxulps the maximum distance.
+ */
+RUNIT_COLD void runit_report_ulp_failure(const runit_site_t* site, uint64_t distance, uint64_t maxulps);
+
+/**
+ * Reports a runit_farray_ulp() failure with the element at the largest ULP
+ * distance and updates the failure counters.
+ */
+RUNIT_COLD void runit_report_farray_ulp_failure(const runit_site_t* site, const float* a, const float* b, size_t count);
+
+/** Same as runit_report_farray_ulp_failure() for runit_darray_ulp(). */
+RUNIT_COLD void runit_report_darray_ulp_failure(const runit_site_t* site,
+                                                const double*       a,
+                                                const double*       b,
+                                                size_t              count);
 
 /**
  * Prints a brief report message providing the point where this report is
@@ -77,25 +1566,56 @@ extern unsigned int runit_counter_assert_passes;
  * multiple of these reports may be added to aid debugging in understanding
  * where the issue arisees.
  */
-#define runit_report()                            \
-    printf("REPORT | File: %s:%d | Test case: %s" \
-           " | Passes: %5u | Failures: %5u\n",    \
-           RUNIT_FILENAME,                        \
-           __LINE__,                              \
-           __func__,                              \
-           runit_counter_assert_passes,           \
-           runit_counter_assert_failures)
+#define runit_report()                      \
+    do                                      \
+    {                                       \
+        RUNIT_SITE_(RUNIT_KIND_REPORT, ""); \
+        runit_report_at(&runit_site_);      \
+    } while (0)
 
 /**
- * Extract only filename from full path (handles both Unix and Windows paths)
+ * Amount of failures of the runit_expect_*() assertions recorded per test
+ * case, see #RUNIT_SOFT_. Further ones are counted, not printed. Only used by
+ * runit.c.
  */
-#if defined(RUNIT_NO_FULL_PATH)
-#    define RUNIT_FILENAME                                   \
-        (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 \
-                                : (strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__))
-#else
-#    define RUNIT_FILENAME (__FILE__)
+#ifndef RUNIT_EXPECT_MAX
+#    define RUNIT_EXPECT_MAX 16U
 #endif
+
+/**
+ * Decides if a failure of a runit_expect_*() assertion is recorded: counts
+ * it and returns 0 once the test case reached #RUNIT_EXPECT_MAX, otherwise
+ * returns 1 and the caller reports it as usual.
+ *
+ * The count restarts with each test case run by runit_run_all() or
+ * runit_main(), and at each runit_report().
+ */
+RUNIT_COLD int runit_expect_record_(void);
+
+/* Zero outside of RUNIT_SOFT_(), which shadows it with 1. */
+enum
+{
+    runit_soft_ = 0
+};
+
+/**
+ * Failure path of all assertion macros: reports the failure and stops the
+ * test case. Inside #RUNIT_SOFT_ the test case goes on instead. The
+ * condition is a constant, so the hard assertions expand as before.
+ */
+#define RUNIT_FAILED_(report)                       \
+    do                                              \
+    {                                               \
+        if (!runit_soft_ || runit_expect_record_()) \
+        {                                           \
+            report;                                 \
+        }                                           \
+        if (!runit_soft_)                           \
+        {                                           \
+            return;                                 \
+        }                                           \
+    } while (0)
+
 /**
  *
  * Verifies if the given boolean expression is true.
@@ -108,9 +1628,12 @@ extern unsigned int runit_counter_assert_passes;
  *
  * The `do-while(0)` construct allows to write multi-line macros.
  *
- * If your system does not support `printf()`, replace it with something
- * else in this file! For example a `transmit()` function to communicate
- * the result to other devices.
+ * Only the comparison and one counter increment are expanded at the call
+ * site. The location of the assertion is stored in a constant call-site
+ * descriptor and handed to runit_report_failure(), which is the only place
+ * formatting the failure. To send it somewhere else than the standard
+ * output, set a sink with runit_set_sink()! For example a `transmit()`
+ * function to communicate the result to other devices.
  *
  * Example:
  * ```
@@ -119,20 +1642,25 @@ extern unsigned int runit_counter_assert_passes;
  * runit_assert(3 < 1);  // Fails
  * ```
  */
-#define runit_assert(expression)                                                                \
-    do                                                                                          \
-    {                                                                                           \
-        if (!(expression))                                                                      \
-        {                                                                                       \
-            printf("FAIL | File: %s:%d | Test case: %s\n", RUNIT_FILENAME, __LINE__, __func__); \
-            runit_counter_assert_failures++;                                                    \
-            runit_at_least_one_fail = 1;                                                        \
-            return;                                                                             \
-        }                                                                                       \
-        else                                                                                    \
-        {                                                                                       \
-            runit_counter_assert_passes++;                                                      \
-        }                                                                                       \
+#define runit_assert(expression) RUNIT_CHECK_(RUNIT_KIND_ASSERT, #expression, expression)
+
+/**
+ * Implementation of all assertion macros: verifies the expression, emitting
+ * a call-site descriptor of the given kind and argument text for the
+ * failure path.
+ */
+#define RUNIT_CHECK_(kind, text, expression)                   \
+    do                                                         \
+    {                                                          \
+        if (RUNIT_LIKELY(expression))                          \
+        {                                                      \
+            RUNIT_COUNT_PASS_();                               \
+        }                                                      \
+        else                                                   \
+        {                                                      \
+            RUNIT_SITE_(kind, text);                           \
+            RUNIT_FAILED_(runit_report_failure(&runit_site_)); \
+        }                                                      \
     } while (0)
 
 /**
@@ -140,7 +1668,7 @@ extern unsigned int runit_counter_assert_passes;
  *
  * Just a rename of runit_assert() for consistency with runit_false().
  */
-#define runit_true(x) runit_assert(x)
+#define runit_true(x) RUNIT_CHECK_(RUNIT_KIND_TRUE, #x, x)
 
 /**
  * Verifies if the given boolean expression is false.
@@ -154,7 +1682,259 @@ extern unsigned int runit_counter_assert_passes;
  * runit_false(0);      // Passes
  * ```
  */
-#define runit_false(x) runit_assert(!(x))
+#define runit_false(x) RUNIT_CHECK_(RUNIT_KIND_FALSE, #x, !(x))
+
+/**
+ * Set to 1 when the comparison macros runit_eq(), runit_neq(), runit_gt(),
+ * runit_ge(), runit_lt() and runit_le() print both values on failure:
+ *
+ * ```
+ * FAIL | File: test.c:42 | Test case: test_parse | Values: 100, 1
+ * ```
+ *
+ * Requires C11 `_Generic`, which picks by the type of each operand how to
+ * store it in a #runit_value_t. The comparison itself still uses the
+ * original types, and nothing is formatted unless it fails. Define
+ * `RUNIT_NO_VALUES` to print the location only, as in C++.
+ */
+#if !defined(RUNIT_NO_VALUES) && !defined(__cplusplus) && defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#    define RUNIT_HAVE_VALUES 1
+#else
+#    define RUNIT_HAVE_VALUES 0
+#endif
+
+/** How a #runit_value_t is stored and printed. */
+typedef enum runit_value_type
+{
+    RUNIT_VALUE_SIGNED = 0,
+    RUNIT_VALUE_UNSIGNED,
+    RUNIT_VALUE_FLOAT,
+    RUNIT_VALUE_DOUBLE,
+    RUNIT_VALUE_LONG_DOUBLE,
+    RUNIT_VALUE_POINTER,
+} runit_value_type_t;
+
+/** Operand of a failing comparison, see #RUNIT_HAVE_VALUES. */
+typedef struct runit_value
+{
+    runit_value_type_t type;
+    union
+    {
+        long long            i;
+        unsigned long long   u;
+        float                f;
+        double               d;
+        long double          ld;
+        const volatile void* p;
+    } as;
+} runit_value_t;
+
+/**
+ * Reports a failing comparison with both values and updates the failure
+ * counters.
+ *
+ * @param[in] site call-site descriptor of the assertion, not NULL.
+ * @param[in] a first operand.
+ * @param[in] b second operand.
+ */
+RUNIT_COLD void runit_report_comparison_failure(const runit_site_t* site, const runit_value_t* a, const runit_value_t* b);
+
+#if RUNIT_HAVE_VALUES
+/* Constructors of runit_value_t for the capture with _Generic. */
+static inline void runit_value_signed_(runit_value_t* const value, const long long x)
+{
+    value->type = RUNIT_VALUE_SIGNED;
+    value->as.i = x;
+}
+
+static inline void runit_value_unsigned_(runit_value_t* const value, const unsigned long long x)
+{
+    value->type = RUNIT_VALUE_UNSIGNED;
+    value->as.u = x;
+}
+
+static inline void runit_value_float_(runit_value_t* const value, const float x)
+{
+    value->type = RUNIT_VALUE_FLOAT;
+    value->as.f = x;
+}
+
+static inline void runit_value_double_(runit_value_t* const value, const double x)
+{
+    value->type = RUNIT_VALUE_DOUBLE;
+    value->as.d = x;
+}
+
+static inline void runit_value_long_double_(runit_value_t* const value, const long double x)
+{
+    value->type = RUNIT_VALUE_LONG_DOUBLE;
+    value->as.ld = x;
+}
+
+static inline void runit_value_pointer_(runit_value_t* const value, const volatile void* const x)
+{
+    value->type = RUNIT_VALUE_POINTER;
+    value->as.p = x;
+}
+
+/* Selected for the operands of any other type, which are compared without capturing them; never called. */
+static inline void runit_value_other_(runit_value_t* const value, ...)
+{
+    (void) value;
+}
+
+/*
+ * The operand with the integer promotions applied, so bit-fields, char,
+ * short and _Bool select int or unsigned int; pointers keep their type.
+ */
+#    define RUNIT_PROMOTED_(x) (1 ? (x) : 0)
+
+/* The pointer types captured by the comparisons: to the arithmetic types and void, with any qualifiers. */
+#    define RUNIT_POINTER_VALUE_(type)                                                                        \
+        type*: runit_value_pointer_, const type*: runit_value_pointer_, volatile type*: runit_value_pointer_, \
+            const volatile type*: runit_value_pointer_
+#    define RUNIT_POINTER_AS_(type, value)                                                            \
+        type*: (type*) (uintptr_t) (value).as.p, const type*: (const type*) (uintptr_t) (value).as.p, \
+            volatile type*: (volatile type*) (uintptr_t) (value).as.p,                                \
+            const volatile type*: (const volatile type*) (uintptr_t) (value).as.p
+
+/*
+ * Constructor of the #runit_value_t of the operand, chosen by its type:
+ * runit_value_other_() for the types that are not captured, e.g. pointers to
+ * structures, bit-fields wider than long long or `__int128`.
+ */
+#    define RUNIT_CAPTURE_(x)                          \
+        _Generic(RUNIT_PROMOTED_(x),                   \
+            int: runit_value_signed_,                  \
+            long: runit_value_signed_,                 \
+            long long: runit_value_signed_,            \
+            unsigned int: runit_value_unsigned_,       \
+            unsigned long: runit_value_unsigned_,      \
+            unsigned long long: runit_value_unsigned_, \
+            float: runit_value_float_,                 \
+            double: runit_value_double_,               \
+            long double: runit_value_long_double_,     \
+            RUNIT_POINTER_VALUE_(void),                \
+            RUNIT_POINTER_VALUE_(_Bool),               \
+            RUNIT_POINTER_VALUE_(char),                \
+            RUNIT_POINTER_VALUE_(signed char),         \
+            RUNIT_POINTER_VALUE_(short),               \
+            RUNIT_POINTER_VALUE_(int),                 \
+            RUNIT_POINTER_VALUE_(long),                \
+            RUNIT_POINTER_VALUE_(long long),           \
+            RUNIT_POINTER_VALUE_(unsigned char),       \
+            RUNIT_POINTER_VALUE_(unsigned short),      \
+            RUNIT_POINTER_VALUE_(unsigned int),        \
+            RUNIT_POINTER_VALUE_(unsigned long),       \
+            RUNIT_POINTER_VALUE_(unsigned long long),  \
+            RUNIT_POINTER_VALUE_(float),               \
+            RUNIT_POINTER_VALUE_(double),              \
+            RUNIT_POINTER_VALUE_(long double),         \
+            default: runit_value_other_)
+
+/** Evaluates the operand once, storing it in a #runit_value_t. */
+#    define RUNIT_VALUE_(value, x) RUNIT_CAPTURE_(x)(value, x)
+
+/** 1 if the operand is captured, as an integer constant expression. */
+#    define RUNIT_CAPTURED_(x) _Generic(RUNIT_CAPTURE_(x), void (*)(runit_value_t*, ...): 0, default: 1)
+
+/**
+ * The captured value back with the promoted type of the operand, without
+ * evaluating the operand again, so the comparison follows the usual C
+ * conversions. Operands that are not captured come back as themselves, for
+ * the comparison that never runs.
+ */
+#    define RUNIT_AS_(x, value)                           \
+        _Generic(RUNIT_PROMOTED_(x),                      \
+            int: (int) (value).as.i,                      \
+            long: (long) (value).as.i,                    \
+            long long: (value).as.i,                      \
+            unsigned int: (unsigned int) (value).as.u,    \
+            unsigned long: (unsigned long) (value).as.u,  \
+            unsigned long long: (value).as.u,             \
+            float: (value).as.f,                          \
+            double: (value).as.d,                         \
+            long double: (value).as.ld,                   \
+            RUNIT_POINTER_AS_(void, value),               \
+            RUNIT_POINTER_AS_(_Bool, value),              \
+            RUNIT_POINTER_AS_(char, value),               \
+            RUNIT_POINTER_AS_(signed char, value),        \
+            RUNIT_POINTER_AS_(short, value),              \
+            RUNIT_POINTER_AS_(int, value),                \
+            RUNIT_POINTER_AS_(long, value),               \
+            RUNIT_POINTER_AS_(long long, value),          \
+            RUNIT_POINTER_AS_(unsigned char, value),      \
+            RUNIT_POINTER_AS_(unsigned short, value),     \
+            RUNIT_POINTER_AS_(unsigned int, value),       \
+            RUNIT_POINTER_AS_(unsigned long, value),      \
+            RUNIT_POINTER_AS_(unsigned long long, value), \
+            RUNIT_POINTER_AS_(float, value),              \
+            RUNIT_POINTER_AS_(double, value),             \
+            RUNIT_POINTER_AS_(long double, value),        \
+            default: (x))
+
+/*
+ * The captured operands are no longer constants, so comparing e.g. an
+ * unsigned variable to a literal 1 would trigger -Wsign-compare. Only the
+ * comparison of the copies ignores it: the original one next to it is
+ * compiled as written and keeps all warnings.
+ */
+#    if defined(__GNUC__) || defined(__clang__)
+#        define RUNIT_MIXED_SIGNS_BEGIN_ \
+            _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wsign-compare\"")
+#        define RUNIT_MIXED_SIGNS_END_ _Pragma("GCC diagnostic pop")
+#    else
+#        define RUNIT_MIXED_SIGNS_BEGIN_
+#        define RUNIT_MIXED_SIGNS_END_
+#    endif
+
+/**
+ * Implementation of the comparison macros: captures both operands, compares
+ * them with their own types and hands them to the cold failure path. Only
+ * the copies made on that path have their address taken, so on the passing
+ * one the operands can stay in registers. If either operand is not captured,
+ * the original comparison runs instead and fails without values, as
+ * #RUNIT_CHECK_ does; it is compiled in any case, so the compiler checks it
+ * as written.
+ */
+#    define RUNIT_COMPARE_(kind, a, op, b)                                                      \
+        do                                                                                      \
+        {                                                                                       \
+            RUNIT_SITE_(kind, #a ", " #b);                                                      \
+            if (RUNIT_CAPTURED_(a) && RUNIT_CAPTURED_(b))                                       \
+            {                                                                                   \
+                runit_value_t runit_a_;                                                         \
+                runit_value_t runit_b_;                                                         \
+                int           runit_ok_;                                                        \
+                RUNIT_VALUE_(&runit_a_, a);                                                     \
+                RUNIT_VALUE_(&runit_b_, b);                                                     \
+                RUNIT_MIXED_SIGNS_BEGIN_                                                        \
+                runit_ok_ = RUNIT_AS_(a, runit_a_) op RUNIT_AS_(b, runit_b_);                   \
+                RUNIT_MIXED_SIGNS_END_                                                          \
+                if (RUNIT_LIKELY(runit_ok_))                                                    \
+                {                                                                               \
+                    RUNIT_COUNT_PASS_();                                                        \
+                }                                                                               \
+                else                                                                            \
+                {                                                                               \
+                    const runit_value_t runit_fa_ = runit_a_;                                   \
+                    const runit_value_t runit_fb_ = runit_b_;                                   \
+                    RUNIT_FAILED_(                                                              \
+                        runit_report_comparison_failure(&runit_site_, &runit_fa_, &runit_fb_)); \
+                }                                                                               \
+            }                                                                                   \
+            else if (RUNIT_LIKELY((a) op (b)))                                                  \
+            {                                                                                   \
+                RUNIT_COUNT_PASS_();                                                            \
+            }                                                                                   \
+            else                                                                                \
+            {                                                                                   \
+                RUNIT_FAILED_(runit_report_failure(&runit_site_));                              \
+            }                                                                                   \
+        } while (0)
+#else
+#    define RUNIT_COMPARE_(kind, a, op, b) RUNIT_CHECK_(kind, #a ", " #b, (a) op (b))
+#endif
 
 /**
  * Verifies if the two arguments are exactly equal.
@@ -170,10 +1950,10 @@ extern unsigned int runit_counter_assert_passes;
  * ```
  * runit_eq(12, 12);      // Passes
  * runit_eq(12.0f, 12U);  // Passes due to implicit conversion of 12U to 12.0f
- * runit_eq(100, 1);      // Fails
+ * runit_eq(100, 1);      // Fails, printing the values (see #RUNIT_HAVE_VALUES)
  * ```
  */
-#define runit_eq(a, b) runit_assert((a) == (b))
+#define runit_eq(a, b) RUNIT_COMPARE_(RUNIT_KIND_EQ, a, ==, b)
 
 /**
  * Verifies if the two arguments are not equal.
@@ -188,7 +1968,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_neq(100, 1);      // Passes
  * ```
  */
-#define runit_neq(a, b) runit_assert((a) != (b))
+#define runit_neq(a, b) RUNIT_COMPARE_(RUNIT_KIND_NEQ, a, !=, b)
 
 /**
  * Verifies if the first argument is strictly Greater Than the second.
@@ -203,7 +1983,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_gt(100, 10);   // Passes
  * ```
  */
-#define runit_gt(a, b) runit_assert((a) > (b))
+#define runit_gt(a, b) RUNIT_COMPARE_(RUNIT_KIND_GT, a, >, b)
 
 /**
  * Verifies if the first argument is Greater or Equal to the second.
@@ -218,7 +1998,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_ge(100, 10);   // Passes
  * ```
  */
-#define runit_ge(a, b) runit_assert((a) >= (b))
+#define runit_ge(a, b) RUNIT_COMPARE_(RUNIT_KIND_GE, a, >=, b)
 
 /**
  * Verifies if the first argument is strictly Less Than the second.
@@ -233,7 +2013,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_lt(100, 10);   // Fails
  * ```
  */
-#define runit_lt(a, b) runit_assert((a) < (b))
+#define runit_lt(a, b) RUNIT_COMPARE_(RUNIT_KIND_LT, a, <, b)
 
 /**
  * Verifies if the first argument is Less or Equal to the second.
@@ -248,7 +2028,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_le(100, 10);   // Fails
  * ```
  */
-#define runit_le(a, b) runit_assert((a) <= (b))
+#define runit_le(a, b) RUNIT_COMPARE_(RUNIT_KIND_LE, a, <=, b)
 
 /**
  * Verifies if two single-precision floating point values are within a given
@@ -263,7 +2043,8 @@ extern unsigned int runit_counter_assert_passes;
  * runit_fdelta(1.0f, 2.0f, 0.1f);         // Fails
  * ```
  */
-#define runit_fdelta(a, b, delta) runit_assert(fabsf((a) - (b)) <= fabsf(delta))
+#define runit_fdelta(a, b, delta) \
+    RUNIT_CHECK_(RUNIT_KIND_FDELTA, #a ", " #b ", " #delta, fabsf((a) - (b)) <= fabsf(delta))
 
 /**
  * Verifies if two single-precision floating point values are within a fixed
@@ -279,7 +2060,8 @@ extern unsigned int runit_counter_assert_passes;
  * runit_fapprox(1.0f, 1.1);        // Fails
  * ```
  */
-#define runit_fapprox(a, b) runit_fdelta((a), (b), RUNIT_FLOAT_EQ_ABSTOL)
+#define runit_fapprox(a, b) \
+    RUNIT_CHECK_(RUNIT_KIND_FAPPROX, #a ", " #b, fabsf((a) - (b)) <= RUNIT_FLOAT_EQ_ABSTOL)
 
 /**
  * Verifies if two double-precision floating point values are within a given
@@ -294,7 +2076,8 @@ extern unsigned int runit_counter_assert_passes;
  * runit_ddelta(1.0, 2.0, 0.1);         // Fails
  * ```
  */
-#define runit_ddelta(a, b, delta) runit_assert(fabs((a) - (b)) <= fabs(delta))
+#define runit_ddelta(a, b, delta) \
+    RUNIT_CHECK_(RUNIT_KIND_DDELTA, #a ", " #b ", " #delta, fabs((a) - (b)) <= fabs(delta))
 
 /**
  * Verifies if two double-precision floating point values are within a fixed
@@ -310,7 +2093,117 @@ extern unsigned int runit_counter_assert_passes;
  * runit_dapprox(1.0, 1.1);         // Fails
  * ```
  */
-#define runit_dapprox(a, b) runit_ddelta((a), (b), RUNIT_DOUBLE_EQ_ABSTOL)
+#define runit_dapprox(a, b) \
+    RUNIT_CHECK_(RUNIT_KIND_DAPPROX, #a ", " #b, fabs((a) - (b)) <= RUNIT_DOUBLE_EQ_ABSTOL)
+
+/**
+ * Verifies if two single-precision floating point values are at most
+ * `maxulps` units in the last place from each other, see
+ * runit_fulp_distance().
+ *
+ * Unlike an absolute tolerance, it scales with the magnitude of the values.
+ * Otherwise stops the test case and reports on standard output the distance:
+ *
+ * ```
+ * FAIL | File: test.c:42 | Test case: test_sqrt | ULP distance: 5 > 4
+ * ```
+ *
+ * Example:
+ * ```
+ * runit_fulp(1e9f, 1e9f + 64.0f, 1);  // Passes, next float
+ * runit_fulp(0.1f + 0.2f, 0.3f, 1);   // Passes
+ * runit_fulp(1.0f, 1.001f, 4);        // Fails, 8389 ULPs
+ * ```
+ */
+#define runit_fulp(a, b, maxulps)                                                                     \
+    do                                                                                                \
+    {                                                                                                 \
+        const uint32_t runit_ulps_ = runit_fulp_distance((a), (b));                                   \
+        if (RUNIT_LIKELY(runit_ulps_ <= (uint32_t) (maxulps)))                                        \
+        {                                                                                             \
+            RUNIT_COUNT_PASS_();                                                                      \
+        }                                                                                             \
+        else                                                                                          \
+        {                                                                                             \
+            RUNIT_SITE_(RUNIT_KIND_FULP, #a ", " #b ", " #maxulps);                                   \
+            RUNIT_FAILED_(runit_report_ulp_failure(&runit_site_, runit_ulps_, (uint64_t) (maxulps))); \
+        }                                                                                             \
+    } while (0)
+
+/**
+ * Verifies if two double-precision floating point values are at most
+ * `maxulps` units in the last place from each other, as runit_fulp().
+ *
+ * Example:
+ * ```
+ * runit_dulp(0.1 + 0.2, 0.3, 1);  // Passes
+ * runit_dulp(1.0, 1.0001, 4);     // Fails
+ * ```
+ */
+#define runit_dulp(a, b, maxulps)                                                                     \
+    do                                                                                                \
+    {                                                                                                 \
+        const uint64_t runit_ulps_ = runit_dulp_distance((a), (b));                                   \
+        if (RUNIT_LIKELY(runit_ulps_ <= (uint64_t) (maxulps)))                                        \
+        {                                                                                             \
+            RUNIT_COUNT_PASS_();                                                                      \
+        }                                                                                             \
+        else                                                                                          \
+        {                                                                                             \
+            RUNIT_SITE_(RUNIT_KIND_DULP, #a ", " #b ", " #maxulps);                                   \
+            RUNIT_FAILED_(runit_report_ulp_failure(&runit_site_, runit_ulps_, (uint64_t) (maxulps))); \
+        }                                                                                             \
+    } while (0)
+
+/**
+ * Verifies if two single-precision floating point values are within a
+ * tolerance relative to the larger magnitude of the two.
+ *
+ * Otherwise stops the test case and reports on standard output.
+ *
+ * Example:
+ * ```
+ * runit_frel(1e9f, 1.0001e9f, 1e-3f);  // Passes
+ * runit_frel(1e-9f, 1.1e-9f, 1e-3f);   // Fails
+ * ```
+ */
+#define runit_frel(a, b, reltol) \
+    RUNIT_CHECK_(RUNIT_KIND_FREL, #a ", " #b ", " #reltol, runit_fclose_within((a), (b), 0.0f, (reltol)))
+
+/**
+ * Verifies if two double-precision floating point values are within a
+ * tolerance relative to the larger magnitude of the two, as runit_frel().
+ */
+#define runit_drel(a, b, reltol) \
+    RUNIT_CHECK_(RUNIT_KIND_DREL, #a ", " #b ", " #reltol, runit_dclose_within((a), (b), 0.0, (reltol)))
+
+/**
+ * Verifies if two single-precision floating point values are within an
+ * absolute or a relative tolerance, whichever is larger: the absolute one
+ * covers values around zero, the relative one large values.
+ *
+ * Otherwise stops the test case and reports on standard output.
+ *
+ * Example:
+ * ```
+ * runit_fclose(0.0f, 1e-7f, 1e-6f, 1e-5f);        // Passes, absolute
+ * runit_fclose(1e9f, 1.000001e9f, 1e-6f, 1e-5f);  // Passes, relative
+ * runit_fclose(1.0f, 1.1f, 1e-6f, 1e-5f);         // Fails
+ * ```
+ */
+#define runit_fclose(a, b, abstol, reltol)             \
+    RUNIT_CHECK_(RUNIT_KIND_FCLOSE,                    \
+                 #a ", " #b ", " #abstol ", " #reltol, \
+                 runit_fclose_within((a), (b), (abstol), (reltol)))
+
+/**
+ * Verifies if two double-precision floating point values are within an
+ * absolute or a relative tolerance, whichever is larger, as runit_fclose().
+ */
+#define runit_dclose(a, b, abstol, reltol)             \
+    RUNIT_CHECK_(RUNIT_KIND_DCLOSE,                    \
+                 #a ", " #b ", " #abstol ", " #reltol, \
+                 runit_dclose_within((a), (b), (abstol), (reltol)))
 
 /**
  * Verifies that the floating point value is Not a Number (NaN).
@@ -326,7 +2219,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_nan(1);          // Fails
  * ```
  */
-#define runit_nan(value) runit_assert(isnan(value))
+#define runit_nan(value) RUNIT_CHECK_(RUNIT_KIND_NAN, #value, isnan(value))
 
 /**
  * Verifies that the floating point value is infinity, either positive or
@@ -343,7 +2236,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_inf(1);          // Fails
  * ```
  */
-#define runit_inf(value) runit_assert(isinf(value))
+#define runit_inf(value) RUNIT_CHECK_(RUNIT_KIND_INF, #value, isinf(value))
 
 /**
  * Verifies that the floating point value is positive infinity.
@@ -359,7 +2252,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_plusinf(1);          // Fails
  * ```
  */
-#define runit_plusinf(value) runit_assert((isinf(value)) && ((value) > 0))
+#define runit_plusinf(value) RUNIT_CHECK_(RUNIT_KIND_PLUSINF, #value, (isinf(value)) && ((value) > 0))
 
 /**
  * Verifies that the floating point value is negative infinity.
@@ -375,7 +2268,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_minusinf(1);          // Fails
  * ```
  */
-#define runit_minusinf(value) runit_assert((isinf(value)) && ((value) < 0))
+#define runit_minusinf(value) RUNIT_CHECK_(RUNIT_KIND_MINUSINF, #value, (isinf(value)) && ((value) < 0))
 
 /**
  * Verifies that the floating point value is finite, thus not NaN or
@@ -392,7 +2285,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_finite(1);          // Passes
  * ```
  */
-#define runit_finite(value) runit_assert(isfinite(value))
+#define runit_finite(value) RUNIT_CHECK_(RUNIT_KIND_FINITE, #value, isfinite(value))
 
 /**
  * Verifies that the floating point value is not finite, thus either NaN or
@@ -409,7 +2302,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_notfinite(1);          // Fails
  * ```
  */
-#define runit_notfinite(value) runit_assert(!isfinite(value))
+#define runit_notfinite(value) RUNIT_CHECK_(RUNIT_KIND_NOTFINITE, #value, !isfinite(value))
 
 /**
  * Verifies if the bits of the value specified by a bit mask are set to 1.
@@ -424,7 +2317,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_flag(0x07, 0xF0);    // Fails
  * ```
  */
-#define runit_flag(value, mask) runit_assert(((value) & (mask)))
+#define runit_flag(value, mask) RUNIT_CHECK_(RUNIT_KIND_FLAG, #value ", " #mask, ((value) & (mask)))
 
 /**
  * Verifies if the bits of the value specified by a bit mask are set to 0.
@@ -438,7 +2331,7 @@ extern unsigned int runit_counter_assert_passes;
  * runit_noflag(0x07, 0x04);    // Fails
  * ```
  */
-#define runit_noflag(value, mask) runit_assert(((value) & (mask)) == 0)
+#define runit_noflag(value, mask) RUNIT_CHECK_(RUNIT_KIND_NOFLAG, #value ", " #mask, ((value) & (mask)) == 0)
 
 /**
  * Verifies if two strings are equal up to a given length or until the shortest
@@ -454,12 +2347,22 @@ extern unsigned int runit_counter_assert_passes;
  * runit_streq("abcd", "ABCD", 4);    // Fails, different casing
  * ```
  */
-#define runit_streq(a, b, maxlen) runit_assert(strncmp((a), (b), (maxlen)) == 0)
+#define runit_streq(a, b, maxlen) \
+    RUNIT_CHECK_(RUNIT_KIND_STREQ, #a ", " #b ", " #maxlen, strncmp((a), (b), (maxlen)) == 0)
 
 /**
  * Verifies if two memory sections are equal up to a given length.
  *
- * Otherwise stops the test case and reports on standard output.
+ * Otherwise stops the test case and reports on standard output the offset of
+ * the first difference and 8 bytes of both sections around it, in hex:
+ *
+ * ```
+ * FAIL | File: test.c:42 | Test case: test_copy | First difference at offset 1027
+ *  | From 1024, a: 00 11 22 33 44 55 66 77 | b: 00 11 22 ff 44 55 66 77
+ * ```
+ *
+ * (on one line). Passing costs a memcmp() only; the difference is searched
+ * on failure, by runit_mismatch_offset().
  *
  * Example:
  * ```
@@ -469,7 +2372,22 @@ extern unsigned int runit_counter_assert_passes;
  * runit_memeq("abcd", "ABCD", 4);    // Fails
  * ```
  */
-#define runit_memeq(a, b, len) runit_assert(memcmp((a), (b), len) == 0)
+#define runit_memeq(a, b, len)                                                                          \
+    do                                                                                                  \
+    {                                                                                                   \
+        const void* const runit_a_      = (a);                                                          \
+        const void* const runit_b_      = (b);                                                          \
+        const size_t      runit_length_ = (size_t) (len);                                               \
+        if (RUNIT_LIKELY(memcmp(runit_a_, runit_b_, runit_length_) == 0))                               \
+        {                                                                                               \
+            RUNIT_COUNT_PASS_();                                                                        \
+        }                                                                                               \
+        else                                                                                            \
+        {                                                                                               \
+            RUNIT_SITE_(RUNIT_KIND_MEMEQ, #a ", " #b ", " #len);                                        \
+            RUNIT_FAILED_(runit_report_memeq_failure(&runit_site_, runit_a_, runit_b_, runit_length_)); \
+        }                                                                                               \
+    } while (0)
 
 /**
  * Verifies if two memory sections are different within the given length.
@@ -484,14 +2402,22 @@ extern unsigned int runit_counter_assert_passes;
  * runit_memneq("abcd", "abCD", 4);    // Passes
  * ```
  */
-#define runit_memneq(a, b, len) runit_assert(memcmp((a), (b), len) != 0)
+#define runit_memneq(a, b, len) RUNIT_CHECK_(RUNIT_KIND_MEMNEQ, #a ", " #b ", " #len, memcmp((a), (b), len) != 0)
 
 /**
  * Verifies if a memory section is filled with just zeros.
  *
  * Useful to check whether a memory location has been cleared.
  *
- * Otherwise stops the test case and reports on standard output.
+ * Otherwise stops the test case and reports on standard output the offset of
+ * the first non-zero byte:
+ *
+ * ```
+ * FAIL | File: test.c:42 | Test case: test_clear | Non-zero byte at offset 1027
+ * ```
+ *
+ * The whole section counts as one assertion and is scanned a word at a time
+ * by runit_nonzero_offset(), so large buffers are cheap to check.
  *
  * Example:
  * ```
@@ -502,13 +2428,20 @@ extern unsigned int runit_counter_assert_passes;
  * runit_zeros("\0\0\0\0", 100);  // UNDEFINED as exceeding known memory
  * ```
  */
-#define runit_zeros(x, len)                                                       \
-    do                                                                            \
-    {                                                                             \
-        for (size_t __runit_idx = 0; __runit_idx < (size_t) (len); __runit_idx++) \
-        {                                                                         \
-            runit_eq(((uint8_t*) (x))[__runit_idx], 0);                           \
-        }                                                                         \
+#define runit_zeros(x, len)                                                         \
+    do                                                                              \
+    {                                                                               \
+        const size_t runit_length_ = (size_t) (len);                                \
+        const size_t runit_offset_ = runit_nonzero_offset((x), runit_length_);      \
+        if (RUNIT_LIKELY(runit_offset_ == runit_length_))                           \
+        {                                                                           \
+            RUNIT_COUNT_PASS_();                                                    \
+        }                                                                           \
+        else                                                                        \
+        {                                                                           \
+            RUNIT_SITE_(RUNIT_KIND_ZEROS, #x ", " #len);                            \
+            RUNIT_FAILED_(runit_report_zeros_failure(&runit_site_, runit_offset_)); \
+        }                                                                           \
     } while (0)
 
 /**
@@ -532,26 +2465,340 @@ extern unsigned int runit_counter_assert_passes;
  * runit_nzeros("\0\0\0\0", 100);  // UNDEFINED as exceeding known memory
  * ```
  */
-#define runit_nzeros(x, len)                                                      \
-    do                                                                            \
-    {                                                                             \
-        uint8_t __runit_all_zero = 1;                                             \
-        for (size_t __runit_idx = 0; __runit_idx < (size_t) (len); __runit_idx++) \
-        {                                                                         \
-            if (((uint8_t*) (x))[__runit_idx] != 0)                               \
-            {                                                                     \
-                __runit_all_zero = 0;                                             \
-                break;                                                            \
-            }                                                                     \
-        }                                                                         \
-        runit_false(__runit_all_zero);                                            \
+#define runit_nzeros(x, len)                                                           \
+    do                                                                                 \
+    {                                                                                  \
+        const size_t runit_length_ = (size_t) (len);                                   \
+        const size_t runit_offset_ = runit_nonzero_offset((x), runit_length_);         \
+        RUNIT_CHECK_(RUNIT_KIND_NZEROS, #x ", " #len, runit_offset_ != runit_length_); \
+    } while (0)
+
+/**
+ * Verifies if all elements of two arrays of floats are within a given absolute
+ * tolerance from each other, as runit_fdelta() on each pair.
+ *
+ * The whole array counts as one assertion and is checked by a single
+ * vectorized pass of runit_farray_within(). Otherwise stops the test case and
+ * reports on standard output the element with the largest error:
+ *
+ * ```
+ * FAIL | File: test.c:42 | Test case: test_filter | Worst index 1027 | a: 0.5 | b: 0.625 | Error: 0.125
+ * ```
+ *
+ * Example:
+ * ```
+ * const float expected[] = {1.0f, 2.0f, 3.0f};
+ * const float output[]   = {1.0f, 2.05f, 3.0f};
+ * runit_farray_delta(expected, output, 3, 0.1f);   // Passes
+ * runit_farray_delta(expected, output, 3, 0.01f);  // Fails, index 1
+ * ```
+ */
+#define runit_farray_delta(a, b, count, delta)                                                          \
+    do                                                                                                  \
+    {                                                                                                   \
+        const float* const runit_a_     = (a);                                                          \
+        const float* const runit_b_     = (b);                                                          \
+        const size_t       runit_count_ = (size_t) (count);                                             \
+        if (RUNIT_LIKELY(runit_farray_within(runit_a_, runit_b_, runit_count_, (delta))))               \
+        {                                                                                               \
+            RUNIT_COUNT_PASS_();                                                                        \
+        }                                                                                               \
+        else                                                                                            \
+        {                                                                                               \
+            RUNIT_SITE_(RUNIT_KIND_FARRAY_DELTA, #a ", " #b ", " #count ", " #delta);                   \
+            RUNIT_FAILED_(runit_report_farray_failure(&runit_site_, runit_a_, runit_b_, runit_count_)); \
+        }                                                                                               \
+    } while (0)
+
+/**
+ * Verifies if all elements of two arrays of doubles are within a given
+ * absolute tolerance from each other, as runit_ddelta() on each pair.
+ *
+ * Counts as one assertion and reports as runit_farray_delta().
+ *
+ * Example:
+ * ```
+ * const double expected[] = {1.0, 2.0, 3.0};
+ * const double output[]   = {1.0, 2.05, 3.0};
+ * runit_darray_delta(expected, output, 3, 0.1);   // Passes
+ * runit_darray_delta(expected, output, 3, 0.01);  // Fails, index 1
+ * ```
+ */
+#define runit_darray_delta(a, b, count, delta)                                                          \
+    do                                                                                                  \
+    {                                                                                                   \
+        const double* const runit_a_     = (a);                                                         \
+        const double* const runit_b_     = (b);                                                         \
+        const size_t        runit_count_ = (size_t) (count);                                            \
+        if (RUNIT_LIKELY(runit_darray_within(runit_a_, runit_b_, runit_count_, (delta))))               \
+        {                                                                                               \
+            RUNIT_COUNT_PASS_();                                                                        \
+        }                                                                                               \
+        else                                                                                            \
+        {                                                                                               \
+            RUNIT_SITE_(RUNIT_KIND_DARRAY_DELTA, #a ", " #b ", " #count ", " #delta);                   \
+            RUNIT_FAILED_(runit_report_darray_failure(&runit_site_, runit_a_, runit_b_, runit_count_)); \
+        }                                                                                               \
+    } while (0)
+
+/**
+ * Verifies if all elements of two arrays of floats are at most `maxulps`
+ * units in the last place from each other, as runit_fulp() on each pair.
+ *
+ * Counts as one assertion. Otherwise stops the test case and reports on
+ * standard output the element at the largest distance:
+ *
+ * ```
+ * FAIL | File: test.c:42 | Test case: test_fft | Worst index 5 | a: 0.5 | b: 0.50000024 | ULP distance: 4
+ * ```
+ */
+#define runit_farray_ulp(a, b, count, maxulps)                                                              \
+    do                                                                                                      \
+    {                                                                                                       \
+        const float* const runit_a_     = (a);                                                              \
+        const float* const runit_b_     = (b);                                                              \
+        const size_t       runit_count_ = (size_t) (count);                                                 \
+        if (RUNIT_LIKELY(runit_farray_ulp_within(runit_a_, runit_b_, runit_count_, (maxulps))))             \
+        {                                                                                                   \
+            RUNIT_COUNT_PASS_();                                                                            \
+        }                                                                                                   \
+        else                                                                                                \
+        {                                                                                                   \
+            RUNIT_SITE_(RUNIT_KIND_FARRAY_ULP, #a ", " #b ", " #count ", " #maxulps);                       \
+            RUNIT_FAILED_(runit_report_farray_ulp_failure(&runit_site_, runit_a_, runit_b_, runit_count_)); \
+        }                                                                                                   \
+    } while (0)
+
+/**
+ * Verifies if all elements of two arrays of doubles are at most `maxulps`
+ * units in the last place from each other, as runit_farray_ulp().
+ */
+#define runit_darray_ulp(a, b, count, maxulps)                                                              \
+    do                                                                                                      \
+    {                                                                                                       \
+        const double* const runit_a_     = (a);                                                             \
+        const double* const runit_b_     = (b);                                                             \
+        const size_t        runit_count_ = (size_t) (count);                                                \
+        if (RUNIT_LIKELY(runit_darray_ulp_within(runit_a_, runit_b_, runit_count_, (maxulps))))             \
+        {                                                                                                   \
+            RUNIT_COUNT_PASS_();                                                                            \
+        }                                                                                                   \
+        else                                                                                                \
+        {                                                                                                   \
+            RUNIT_SITE_(RUNIT_KIND_DARRAY_ULP, #a ", " #b ", " #count ", " #maxulps);                       \
+            RUNIT_FAILED_(runit_report_darray_ulp_failure(&runit_site_, runit_a_, runit_b_, runit_count_)); \
+        }                                                                                                   \
+    } while (0)
+
+/**
+ * Verifies if two arrays of integers of the same size are equal, element by
+ * element.
+ *
+ * The whole array counts as one assertion and passing costs a memcmp() only.
+ * Otherwise stops the test case and reports on standard output the first
+ * differing element, in hex as the signedness is unknown:
+ *
+ * ```
+ * FAIL | File: test.c:42 | Test case: test_decode | First difference at index 17 | a: 0x002a | b: 0xffd6
+ * ```
+ *
+ * Example:
+ * ```
+ * const int16_t expected[] = {1, 2, 3};
+ * const int16_t output[]   = {1, 2, -3};
+ * runit_array_eq(expected, output, 2);  // Passes
+ * runit_array_eq(expected, output, 3);  // Fails, index 2
+ * ```
+ */
+#define runit_array_eq(a, b, count)                                                                                  \
+    do                                                                                                               \
+    {                                                                                                                \
+        const void* const runit_a_     = (a);                                                                        \
+        const void* const runit_b_     = (b);                                                                        \
+        const size_t      runit_count_ = (size_t) (count);                                                           \
+        (void) sizeof(char[sizeof(*(a)) == sizeof(*(b)) ? 1 : -1]); /* Same element size */                          \
+        if (RUNIT_LIKELY(memcmp(runit_a_, runit_b_, runit_count_ * sizeof(*(a))) == 0))                              \
+        {                                                                                                            \
+            RUNIT_COUNT_PASS_();                                                                                     \
+        }                                                                                                            \
+        else                                                                                                         \
+        {                                                                                                            \
+            RUNIT_SITE_(RUNIT_KIND_ARRAY_EQ, #a ", " #b ", " #count);                                                \
+            RUNIT_FAILED_(runit_report_array_failure(&runit_site_, runit_a_, runit_b_, runit_count_, sizeof(*(a)))); \
+        }                                                                                                            \
     } while (0)
 
 /**
  * Forces a failure of the test case, stopping it and reporting on standard
  * output.
  */
-#define runit_fail() runit_assert(0)
+#define runit_fail() RUNIT_CHECK_(RUNIT_KIND_FAIL, "", 0)
+
+/**
+ * Implementation of the performance assertions: times the statement with the
+ * given clock the given amount of times, then verifies the statistic against
+ * the budget.
+ */
+#define RUNIT_TIMED_(kind, text, clock, budget, statistic, repeats, ...)                                   \
+    do                                                                                                     \
+    {                                                                                                      \
+        runit_timing_t runit_timing_;                                                                      \
+        runit_timing_begin(&runit_timing_, clock, statistic, repeats);                                     \
+        do                                                                                                 \
+        {                                                                                                  \
+            runit_timing_.start = clock();                                                                 \
+            __VA_ARGS__;                                                                                   \
+        } while (runit_timing_next(&runit_timing_));                                                       \
+        if (RUNIT_LIKELY(runit_timing_.value <= (uint64_t) (budget)))                                      \
+        {                                                                                                  \
+            RUNIT_COUNT_PASS_();                                                                           \
+        }                                                                                                  \
+        else                                                                                               \
+        {                                                                                                  \
+            RUNIT_SITE_(kind, text);                                                                       \
+            RUNIT_FAILED_(runit_report_timing_failure(&runit_site_, &runit_timing_, (uint64_t) (budget))); \
+        }                                                                                                  \
+    } while (0)
+
+/**
+ * Verifies that the given statement or block runs within a budget of
+ * nanoseconds.
+ *
+ * Runs it `repeats` times (at most #RUNIT_TIMING_SAMPLES), timing each run
+ * with runit_clock_ns() minus the cost of reading the clock, then compares the
+ * chosen statistic of the runs with the budget. Otherwise stops the test case
+ * and reports the measured value:
+ *
+ * ```
+ * FAIL | File: test.c:42 | Test case: test_parser_latency | Median of 20: 2310 ns > 2000 ns
+ * ```
+ *
+ * No heap: the runs are kept in a static buffer, not thread-safe.
+ *
+ * Example:
+ * ```
+ * runit_max_ns(2000, RUNIT_MEDIAN, 20, parse_frame(&parser, frame, sizeof(frame)));
+ * runit_max_ns(500, RUNIT_MIN, 10, {
+ *     reset(&parser);
+ *     parse_byte(&parser, 0x55);
+ * });
+ * ```
+ */
+#define runit_max_ns(budget, statistic, repeats, ...)                     \
+    RUNIT_TIMED_(RUNIT_KIND_MAX_NS,                                       \
+                 #budget ", " #statistic ", " #repeats ", " #__VA_ARGS__, \
+                 runit_clock_ns,                                          \
+                 budget,                                                  \
+                 statistic,                                               \
+                 repeats,                                                 \
+                 __VA_ARGS__)
+
+#if RUNIT_HAVE_CLOCK_CYCLES
+/**
+ * Same as runit_max_ns(), with a budget of CPU cycles measured with
+ * runit_clock_cycles(). Requires #RUNIT_HAVE_CLOCK_CYCLES.
+ */
+#    define runit_max_cycles(budget, statistic, repeats, ...)                 \
+        RUNIT_TIMED_(RUNIT_KIND_MAX_CYCLES,                                   \
+                     #budget ", " #statistic ", " #repeats ", " #__VA_ARGS__, \
+                     runit_clock_cycles,                                      \
+                     budget,                                                  \
+                     statistic,                                               \
+                     repeats,                                                 \
+                     __VA_ARGS__)
+#endif
+
+/* Declaring the shadowing runit_soft_ is the whole point of RUNIT_SOFT_(). */
+#if defined(__GNUC__) || defined(__clang__)
+#    define RUNIT_SHADOW_BEGIN_ _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wshadow\"")
+#    define RUNIT_SHADOW_END_   _Pragma("GCC diagnostic pop")
+#else
+#    define RUNIT_SHADOW_BEGIN_
+#    define RUNIT_SHADOW_END_
+#endif
+
+/**
+ * Turns an assertion into a soft one: on failure it is reported and counted
+ * as usual, then the test case goes on with the next statement.
+ *
+ * The assertion macro is expanded unchanged, in a scope where #RUNIT_FAILED_
+ * takes the other branch: the passing path is the same code, the failure goes
+ * through the same cold report functions. At most #RUNIT_EXPECT_MAX failures
+ * are printed per test case, the rest is only counted.
+ */
+#define RUNIT_SOFT_(assertion) \
+    do                         \
+    {                          \
+        RUNIT_SHADOW_BEGIN_    \
+        enum                   \
+        {                      \
+            runit_soft_ = 1    \
+        };                     \
+        RUNIT_SHADOW_END_      \
+        assertion;             \
+    } while (0)
+
+/**
+ * @name Soft assertions
+ *
+ * Same as the runit_*() assertion with the same name, but a failure does not
+ * stop the test case: useful to check many fields at once, e.g. of a decoded
+ * packet, and see all the wrong ones in one run.
+ *
+ * ```
+ * runit_expect_eq(packet.id, 7);           // Fails, reported
+ * runit_expect_eq(packet.length, 12);      // Still verified
+ * runit_expect_memeq(packet.payload, expected, 12);
+ * ```
+ *
+ * The failures count as usual, so the test suite fails at the end. See
+ * #RUNIT_SOFT_ and #RUNIT_EXPECT_MAX.
+ * @{
+ */
+#define runit_expect_assert(expression)               RUNIT_SOFT_(runit_assert(expression))
+#define runit_expect_true(x)                          RUNIT_SOFT_(runit_true(x))
+#define runit_expect_false(x)                         RUNIT_SOFT_(runit_false(x))
+#define runit_expect_eq(a, b)                         RUNIT_SOFT_(runit_eq(a, b))
+#define runit_expect_neq(a, b)                        RUNIT_SOFT_(runit_neq(a, b))
+#define runit_expect_gt(a, b)                         RUNIT_SOFT_(runit_gt(a, b))
+#define runit_expect_ge(a, b)                         RUNIT_SOFT_(runit_ge(a, b))
+#define runit_expect_lt(a, b)                         RUNIT_SOFT_(runit_lt(a, b))
+#define runit_expect_le(a, b)                         RUNIT_SOFT_(runit_le(a, b))
+#define runit_expect_fdelta(a, b, delta)              RUNIT_SOFT_(runit_fdelta(a, b, delta))
+#define runit_expect_fapprox(a, b)                    RUNIT_SOFT_(runit_fapprox(a, b))
+#define runit_expect_ddelta(a, b, delta)              RUNIT_SOFT_(runit_ddelta(a, b, delta))
+#define runit_expect_dapprox(a, b)                    RUNIT_SOFT_(runit_dapprox(a, b))
+#define runit_expect_fulp(a, b, maxulps)              RUNIT_SOFT_(runit_fulp(a, b, maxulps))
+#define runit_expect_dulp(a, b, maxulps)              RUNIT_SOFT_(runit_dulp(a, b, maxulps))
+#define runit_expect_frel(a, b, reltol)               RUNIT_SOFT_(runit_frel(a, b, reltol))
+#define runit_expect_drel(a, b, reltol)               RUNIT_SOFT_(runit_drel(a, b, reltol))
+#define runit_expect_fclose(a, b, abstol, reltol)     RUNIT_SOFT_(runit_fclose(a, b, abstol, reltol))
+#define runit_expect_dclose(a, b, abstol, reltol)     RUNIT_SOFT_(runit_dclose(a, b, abstol, reltol))
+#define runit_expect_nan(value)                       RUNIT_SOFT_(runit_nan(value))
+#define runit_expect_inf(value)                       RUNIT_SOFT_(runit_inf(value))
+#define runit_expect_plusinf(value)                   RUNIT_SOFT_(runit_plusinf(value))
+#define runit_expect_minusinf(value)                  RUNIT_SOFT_(runit_minusinf(value))
+#define runit_expect_finite(value)                    RUNIT_SOFT_(runit_finite(value))
+#define runit_expect_notfinite(value)                 RUNIT_SOFT_(runit_notfinite(value))
+#define runit_expect_flag(value, mask)                RUNIT_SOFT_(runit_flag(value, mask))
+#define runit_expect_noflag(value, mask)              RUNIT_SOFT_(runit_noflag(value, mask))
+#define runit_expect_streq(a, b, maxlen)              RUNIT_SOFT_(runit_streq(a, b, maxlen))
+#define runit_expect_memeq(a, b, len)                 RUNIT_SOFT_(runit_memeq(a, b, len))
+#define runit_expect_memneq(a, b, len)                RUNIT_SOFT_(runit_memneq(a, b, len))
+#define runit_expect_zeros(x, len)                    RUNIT_SOFT_(runit_zeros(x, len))
+#define runit_expect_nzeros(x, len)                   RUNIT_SOFT_(runit_nzeros(x, len))
+#define runit_expect_farray_delta(a, b, count, delta) RUNIT_SOFT_(runit_farray_delta(a, b, count, delta))
+#define runit_expect_darray_delta(a, b, count, delta) RUNIT_SOFT_(runit_darray_delta(a, b, count, delta))
+#define runit_expect_farray_ulp(a, b, count, maxulps) RUNIT_SOFT_(runit_farray_ulp(a, b, count, maxulps))
+#define runit_expect_darray_ulp(a, b, count, maxulps) RUNIT_SOFT_(runit_darray_ulp(a, b, count, maxulps))
+#define runit_expect_array_eq(a, b, count)            RUNIT_SOFT_(runit_array_eq(a, b, count))
+#define runit_expect_max_ns(budget, statistic, repeats, ...) \
+    RUNIT_SOFT_(runit_max_ns(budget, statistic, repeats, __VA_ARGS__))
+#if RUNIT_HAVE_CLOCK_CYCLES
+#    define runit_expect_max_cycles(budget, statistic, repeats, ...) \
+        RUNIT_SOFT_(runit_max_cycles(budget, statistic, repeats, __VA_ARGS__))
+#endif
+/** @} */
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,342 @@
+#!/usr/bin/env python3
+"""
+Decoder of the tokenized runit output.
+
+A runit build with RUNIT_TOKENIZED defined does not print the FAIL and
+REPORT lines, but emits compact binary records instead:
+
+    0xFF | token (uint32 LE) | argc (uint8) | argc x argument (uint32 LE)
+
+The token is the index of the call-site descriptor of the assertion in the
+`runit_sites` section of the ELF file. This tool reads that table from the ELF
+file of the test executable or firmware and rebuilds the text lines as runit
+would have printed them. All other bytes of the stream (e.g. text printed by
+the test suite itself) are copied unchanged; 0xFF never occurs in UTF-8 text.
+
+Usage:
+    runit_detokenize.py [--no-full-path] [--unit UNIT] ELF_FILE [INPUT_FILE]
+
+Without INPUT_FILE the stream is read from the standard input.
+Only the Python standard library is required.
+"""
+
+import argparse
+import signal
+import struct
+import sys
+
+TOKEN_MARKER = 0xFF
+KIND_EQ = 3  # RUNIT_KIND_EQ in runit.h
+KIND_LE = 8  # RUNIT_KIND_LE in runit.h
+KIND_MEMEQ = 22  # RUNIT_KIND_MEMEQ in runit.h
+KIND_ZEROS = 24  # RUNIT_KIND_ZEROS in runit.h
+KIND_REPORT = 27  # RUNIT_KIND_REPORT in runit.h
+KIND_BENCH = 28  # RUNIT_KIND_BENCH in runit.h
+KIND_MAX_NS = 29  # RUNIT_KIND_MAX_NS in runit.h
+KIND_MAX_CYCLES = 30  # RUNIT_KIND_MAX_CYCLES in runit.h
+KIND_FARRAY_DELTA = 31  # RUNIT_KIND_FARRAY_DELTA in runit.h
+KIND_DARRAY_DELTA = 32  # RUNIT_KIND_DARRAY_DELTA in runit.h
+KIND_ARRAY_EQ = 33  # RUNIT_KIND_ARRAY_EQ in runit.h
+KIND_FULP = 34  # RUNIT_KIND_FULP in runit.h
+KIND_DULP = 35  # RUNIT_KIND_DULP in runit.h
+KIND_FARRAY_ULP = 36  # RUNIT_KIND_FARRAY_ULP in runit.h
+KIND_DARRAY_ULP = 37  # RUNIT_KIND_DARRAY_ULP in runit.h
+KIND_SLOWEST = 42  # RUNIT_KIND_SLOWEST in runit.h
+KIND_TIMES = 43  # RUNIT_KIND_TIMES in runit.h
+KIND_HISTOGRAM = 44  # RUNIT_KIND_HISTOGRAM in runit.h
+KIND_CRASH = 45  # RUNIT_KIND_CRASH in runit.h
+KIND_TIMEOUT = 46  # RUNIT_KIND_TIMEOUT in runit.h
+KIND_HARDFAULT = 47  # RUNIT_KIND_HARDFAULT in runit.h
+HISTOGRAM = ("<0.1 ms", "<1 ms", "<10 ms", "<100 ms", "<1 s", "<10 s", ">=10 s")
+STATISTICS = ("Min", "Median", "P95")  # runit_statistic_t
+BENCH_REGRESSION_ARGS = 3  # RUNIT_BENCH_REGRESSION_ARGS in runit.c
+ELEMENT_ARGS = 7  # RUNIT_ELEMENT_ARGS in runit.c
+COMPARISON_ARGS = 6  # RUNIT_COMPARISON_ARGS in runit.c
+VALUE_SIGNED, VALUE_UNSIGNED, VALUE_FLOAT, VALUE_POINTER = 0, 1, 2, 5  # runit_value_type_t
+
+SHT_RELA = 4
+RELATIVE_RELOCATIONS = {
+    62: 8,  # EM_X86_64: R_X86_64_RELATIVE
+    183: 1027,  # EM_AARCH64: R_AARCH64_RELATIVE
+    243: 3,  # EM_RISCV: R_RISCV_RELATIVE
+}
+
+
+class Elf:
+    """Minimal little-endian ELF reader: sections and constant data only."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError(f"{path} is not an ELF file")
+        if self.data[5] != 1:
+            raise ValueError(f"{path}: only little-endian ELF files are supported")
+        self.is64 = self.data[4] == 2
+        self.ptr_size = 8 if self.is64 else 4
+        if self.is64:
+            (self.machine,) = struct.unpack_from("<H", self.data, 18)
+            shoff, = struct.unpack_from("<Q", self.data, 40)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 58)
+        else:
+            (self.machine,) = struct.unpack_from("<H", self.data, 18)
+            shoff, = struct.unpack_from("<I", self.data, 32)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 46)
+        self.sections = []
+        for i in range(shnum):
+            off = shoff + i * shentsize
+            if self.is64:
+                name, stype, _, addr, offset, size, _, _, _, entsize = struct.unpack_from("<IIQQQQIIQQ", self.data, off)
+            else:
+                name, stype, _, addr, offset, size, _, _, _, entsize = struct.unpack_from("<IIIIIIIIII", self.data, off)
+            self.sections.append({"name": name, "type": stype, "addr": addr, "offset": offset, "size": size,
+                                  "entsize": entsize})
+        names = self.sections[shstrndx]
+        for section in self.sections:
+            section["name"] = self._cstring_at(names["offset"] + section["name"])
+        self.relocated = self._relative_relocations()
+
+    def _cstring_at(self, offset):
+        end = self.data.index(b"\0", offset)
+        return self.data[offset:end].decode("utf-8", errors="replace")
+
+    def _relative_relocations(self):
+        """Values of RELATIVE relocations (position independent executables) by address."""
+        relocated = {}
+        relative = RELATIVE_RELOCATIONS.get(self.machine)
+        if relative is None:
+            return relocated
+        for section in self.sections:
+            if section["type"] != SHT_RELA:
+                continue
+            for off in range(section["offset"], section["offset"] + section["size"], section["entsize"]):
+                if self.is64:
+                    where, info, addend = struct.unpack_from("<QQq", self.data, off)
+                    rtype = info & 0xFFFFFFFF
+                else:
+                    where, info, addend = struct.unpack_from("<IIi", self.data, off)
+                    rtype = info & 0xFF
+                if rtype == relative:
+                    relocated[where] = addend
+        return relocated
+
+    def section(self, name):
+        for section in self.sections:
+            if section["name"] == name:
+                return section
+        return None
+
+    def pointer_at(self, address):
+        if address in self.relocated:
+            return self.relocated[address]
+        return struct.unpack_from("<Q" if self.is64 else "<I", self.data, self._file_offset(address))[0]
+
+    def string_at(self, address):
+        return self._cstring_at(self._file_offset(address))
+
+    def _file_offset(self, address):
+        for section in self.sections:
+            if section["addr"] <= address < section["addr"] + section["size"] and section["type"] != 8:  # NOBITS
+                return section["offset"] + address - section["addr"]
+        raise ValueError(f"address 0x{address:x} is not stored in the ELF file")
+
+
+def read_sites(elf):
+    """Call-site descriptors of runit_sites, in token order."""
+    section = elf.section("runit_sites")
+    if section is None:
+        raise ValueError("the ELF file has no runit_sites section")
+    ptr = elf.ptr_size
+    # runit_site_t: file, function, expression pointers, then line and kind
+    entry_size = 3 * ptr + 8
+    entry_size = (entry_size + ptr - 1) // ptr * ptr
+    sites = []
+    for address in range(section["addr"], section["addr"] + section["size"], entry_size):
+        line, kind = struct.unpack_from("<II", elf.data, elf._file_offset(address + 3 * ptr))
+        sites.append({
+            "file": elf.string_at(elf.pointer_at(address)),
+            "function": elf.string_at(elf.pointer_at(address + ptr)),
+            "expression": elf.string_at(elf.pointer_at(address + 2 * ptr)),
+            "line": line,
+            "kind": kind,
+        })
+    return sites
+
+
+def read_tests(elf):
+    """Test case descriptors of runit_tests, in the order they run."""
+    section = elf.section("runit_tests")
+    if section is None:
+        return []
+    ptr = elf.ptr_size
+    # runit_test_t: name, function and file pointers, then line; pointer aligned
+    entry_size = (3 * ptr + 4 + ptr - 1) // ptr * ptr
+    tests = []
+    for address in range(section["addr"], section["addr"] + section["size"], entry_size):
+        (line,) = struct.unpack_from("<I", elf.data, elf._file_offset(address + 3 * ptr))
+        tests.append({
+            "name": elf.string_at(elf.pointer_at(address)),
+            "file": elf.string_at(elf.pointer_at(address + 2 * ptr)),
+            "line": line,
+        })
+    return tests
+
+
+def signal_name(number):
+    """Name of a signal caught by runit_set_crash_recovery(), on this host."""
+    if number == 0:
+        return "reset"  # Noticed by runit_resume()
+    caught = ("SIGSEGV", "SIGBUS", "SIGFPE", "SIGILL")
+    return next((name for name in caught if getattr(signal, name, None) == number), "?")
+
+
+def milliseconds(microseconds):
+    return f"{microseconds // 1000}.{microseconds % 1000:03d}"
+
+
+def hundredths(value):
+    return f"{value // 100}.{value % 100:02d}"
+
+
+def hex_window(packed, count):
+    data = struct.pack("<2I", *packed)[:count]
+    return " ".join(f"{byte:02x}" for byte in data)
+
+
+def double(low, high):
+    return struct.unpack("<d", struct.pack("<2I", low, high))[0]
+
+
+def value(kind, low, high):
+    bits = low | high << 32
+    if kind == VALUE_SIGNED:
+        return str(bits - (1 << 64) if bits >> 63 else bits)
+    if kind == VALUE_UNSIGNED:
+        return str(bits)
+    if kind == VALUE_POINTER:
+        return f"0x{bits:x}"
+    return f"{double(low, high):.{9 if kind == VALUE_FLOAT else 17}g}"
+
+
+def file_name(path, no_full_path):
+    return path.replace("\\", "/").rsplit("/", 1)[-1] if no_full_path else path
+
+
+def format_record(site, args, no_full_path, unit, tests=()):
+    file = file_name(site["file"], no_full_path)
+    if site["kind"] == KIND_SLOWEST:
+        test = tests[args[0]]
+        return (f"SLOWEST | File: {file_name(test['file'], no_full_path)}:{test['line']}"
+                f" | Test case: {test['name']} | Time: {milliseconds(args[1])} ms\n")
+    if site["kind"] == KIND_CRASH:
+        test = tests[args[0]]
+        return (f"CRASH | File: {file_name(test['file'], no_full_path)}:{test['line']}"
+                f" | Test case: {test['name']} | Signal: {signal_name(args[1])} ({args[1]})\n")
+    if site["kind"] == KIND_TIMEOUT:
+        test = tests[args[0]]
+        return (f"TIMEOUT | File: {file_name(test['file'], no_full_path)}:{test['line']}"
+                f" | Test case: {test['name']} | Elapsed: {args[1]} ms | Limit: {args[2]} ms"
+                f"{' for all test cases' if args[3] else ''}\n")
+    if site["kind"] == KIND_HARDFAULT:
+        test = tests[args[0]] if args[0] < len(tests) else {"file": "?", "line": 0, "name": "(none)"}
+        registers = zip(("PC", "LR", "xPSR", "CFSR", "HFSR", "MMFAR", "BFAR"), args[1:8])
+        return (f"HARDFAULT | File: {file_name(test['file'], no_full_path)}:{test['line']} | Test case: {test['name']}"
+                + "".join(f" | {name}: 0x{register:08X}" for name, register in registers) + "\n")
+    if site["kind"] == KIND_TIMES:
+        return (f"TIMES | Test cases: {args[0]} | Sum: {milliseconds(args[1] | args[2] << 32)} ms"
+                f" | Wall: {milliseconds(args[3] | args[4] << 32)} ms\n")
+    if site["kind"] == KIND_HISTOGRAM:
+        return "HISTOGRAM | " + " | ".join(f"{name}: {count}" for name, count in zip(HISTOGRAM, args)) + "\n"
+    if site["kind"] == KIND_REPORT:
+        return (f"REPORT | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | Passes: {args[0]:5d} | Failures: {args[1]:5d}\n")
+    if KIND_EQ <= site["kind"] <= KIND_LE and len(args) == COMPARISON_ARGS:
+        return (f"FAIL | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | Values: {value(*args[0:3])}, {value(*args[3:6])}\n")
+    if site["kind"] == KIND_MEMEQ and len(args) == ELEMENT_ARGS:
+        return (f"FAIL | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | First difference at offset {args[0]}"
+                f" | From {args[1]}, a: {hex_window(args[3:5], args[2])} | b: {hex_window(args[5:7], args[2])}\n")
+    if site["kind"] in (KIND_FARRAY_DELTA, KIND_DARRAY_DELTA):
+        digits = 9 if site["kind"] == KIND_FARRAY_DELTA else 17
+        a, b, error = double(*args[1:3]), double(*args[3:5]), double(*args[5:7])
+        return (f"FAIL | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | Worst index {args[0]} | a: {a:.{digits}g} | b: {b:.{digits}g} | Error: {error:.{digits}g}\n")
+    if site["kind"] in (KIND_FARRAY_ULP, KIND_DARRAY_ULP):
+        digits = 9 if site["kind"] == KIND_FARRAY_ULP else 17
+        a, b = double(*args[1:3]), double(*args[3:5])
+        return (f"FAIL | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | Worst index {args[0]} | a: {a:.{digits}g} | b: {b:.{digits}g}"
+                f" | ULP distance: {args[5] | args[6] << 32}\n")
+    if site["kind"] in (KIND_FULP, KIND_DULP):
+        return (f"FAIL | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | ULP distance: {args[0] | args[1] << 32} > {args[2] | args[3] << 32}\n")
+    if site["kind"] == KIND_ARRAY_EQ:
+        digits = args[1] * 2
+        a, b = args[2] | args[3] << 32, args[4] | args[5] << 32
+        return (f"FAIL | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | First difference at index {args[0]} | a: 0x{a:0{digits}x} | b: 0x{b:0{digits}x}\n")
+    if site["kind"] == KIND_ZEROS and len(args) == 1:
+        return (f"FAIL | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | Non-zero byte at offset {args[0]}\n")
+    if site["kind"] in (KIND_MAX_NS, KIND_MAX_CYCLES):
+        budget_unit = "ns" if site["kind"] == KIND_MAX_NS else "cycles"
+        return (f"FAIL | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | {STATISTICS[min(args[2], 2)]} of {args[3]}: {args[0]} {budget_unit} > {args[1]} {budget_unit}\n")
+    if site["kind"] == KIND_BENCH and len(args) == BENCH_REGRESSION_ARGS:
+        return (f"FAIL | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | Regression: {site['expression']}"
+                f" | Median: {hundredths(args[0])} -> {hundredths(args[1])} | z: {hundredths(args[2])}\n")
+    if site["kind"] == KIND_BENCH:
+        return (f"BENCH | File: {file}:{site['line']} | Test case: {site['function']}"
+                f" | Name: {site['expression']} | Samples: {args[0]} x {args[1]}"
+                f" | Min: {hundredths(args[2])} | Median: {hundredths(args[3])}"
+                f" | Mean: {hundredths(args[4])} | P99: {hundredths(args[5])}"
+                f" | Stddev: {hundredths(args[6])} | Unit: {unit}\n")
+    return f"FAIL | File: {file}:{site['line']} | Test case: {site['function']}\n"
+
+
+def decode(stream, sites, no_full_path, unit="ns", tests=()):
+    out = bytearray()
+    i = 0
+    while i < len(stream):
+        if stream[i] != TOKEN_MARKER:
+            out.append(stream[i])
+            i += 1
+            continue
+        if i + 6 > len(stream):
+            raise ValueError(f"truncated record at offset {i}")
+        token, argc = struct.unpack_from("<IB", stream, i + 1)
+        if i + 6 + 4 * argc > len(stream):
+            raise ValueError(f"truncated record at offset {i}")
+        args = struct.unpack_from(f"<{argc}I", stream, i + 6)
+        if token >= len(sites):
+            raise ValueError(f"unknown token {token} at offset {i}")
+        out += format_record(sites[token], args, no_full_path, unit, tests).encode()
+        i += 6 + 4 * argc
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes the tokenized runit output.")
+    parser.add_argument("--no-full-path", action="store_true",
+                        help="print only file names, as RUNIT_NO_FULL_PATH does")
+    parser.add_argument("--unit", default="ns",
+                        help="unit of the clock of the benchmarks, see runit_set_clock()")
+    parser.add_argument("elf", help="ELF file of the test executable or firmware")
+    parser.add_argument("input", nargs="?", help="tokenized output, standard input if omitted")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    sites = read_sites(elf)
+    tests = read_tests(elf)
+    if args.input:
+        with open(args.input, "rb") as f:
+            stream = f.read()
+    else:
+        stream = sys.stdin.buffer.read()
+    sys.stdout.buffer.write(decode(stream, sites, args.no_full_path, args.unit, tests))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,164 @@
+/**
+ * @file
+ * Throughput of the array assertions on a host, compared with asserting every
+ * element on its own in a loop, as before they existed.
+ *
+ * The results are printed on stderr.
+ * Usage: runit-bench-arrays [elements]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "runit.h"
+#include <stdlib.h> /* For malloc(), strtoul() */
+#include <time.h>   /* For clock_gettime() */
+
+static float*   floats_a;
+static float*   floats_b;
+static double*  doubles_a;
+static double*  doubles_b;
+static int32_t* ints_a;
+static int32_t* ints_b;
+static size_t   count;
+
+static void floats_per_element(void)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        runit_fdelta(floats_a[i], floats_b[i], 1e-3f);
+    }
+}
+
+static void floats_array(void)
+{
+    runit_farray_delta(floats_a, floats_b, count, 1e-3f);
+}
+
+static void doubles_per_element(void)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        runit_ddelta(doubles_a[i], doubles_b[i], 1e-9);
+    }
+}
+
+static void doubles_array(void)
+{
+    runit_darray_delta(doubles_a, doubles_b, count, 1e-9);
+}
+
+static void floats_ulp_per_element(void)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        runit_fulp(floats_a[i], floats_b[i], 1000U);
+    }
+}
+
+static void floats_ulp_array(void)
+{
+    runit_farray_ulp(floats_a, floats_b, count, 1000U);
+}
+
+static void doubles_ulp_per_element(void)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        runit_dulp(doubles_a[i], doubles_b[i], 1000000U);
+    }
+}
+
+static void doubles_ulp_array(void)
+{
+    runit_darray_ulp(doubles_a, doubles_b, count, 1000000U);
+}
+
+static void ints_per_element(void)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        runit_eq(ints_a[i], ints_b[i]);
+    }
+}
+
+static void ints_array(void)
+{
+    runit_array_eq(ints_a, ints_b, count);
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Best of a few runs, in million elements per second. */
+static double bench(void (*check)(void))
+{
+    double best = 0;
+
+    for (unsigned int run = 0; run < 5U; run++)
+    {
+        const double start   = now_seconds();
+        double       elapsed = 0;
+        check();
+        elapsed = now_seconds() - start;
+        if (best == 0 || elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+    return (double) count / best * 1e-6;
+}
+
+static void compare(const char* name, void (*per_element)(void), void (*array)(void))
+{
+    const double slow = bench(per_element);
+    const double fast = bench(array);
+
+    fprintf(stderr,
+            "BENCH | %-10s | %lu elements | per element %8.1f M/s | array %8.1f M/s | speedup %5.1fx\n",
+            name,
+            (unsigned long) count,
+            slow,
+            fast,
+            fast / slow);
+}
+
+int main(int argc, char** argv)
+{
+    count     = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000UL;
+    floats_a  = malloc(count * sizeof(float));
+    floats_b  = malloc(count * sizeof(float));
+    doubles_a = malloc(count * sizeof(double));
+    doubles_b = malloc(count * sizeof(double));
+    ints_a    = malloc(count * sizeof(int32_t));
+    ints_b    = malloc(count * sizeof(int32_t));
+    if (floats_a == NULL || floats_b == NULL || doubles_a == NULL || doubles_b == NULL || ints_a == NULL
+        || ints_b == NULL)
+    {
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        floats_a[i]  = 1.0f + (float) (i % 1000U) * 0.001f;
+        floats_b[i]  = floats_a[i] + 1e-4f;
+        doubles_a[i] = 1.0 + (double) i * 1e-3;
+        doubles_b[i] = doubles_a[i] - 1e-10;
+        ints_a[i]    = (int32_t) i;
+        ints_b[i]    = (int32_t) i;
+    }
+    compare("float", floats_per_element, floats_array);
+    compare("double", doubles_per_element, doubles_array);
+    compare("float ULP", floats_ulp_per_element, floats_ulp_array);
+    compare("double ULP", doubles_ulp_per_element, doubles_ulp_array);
+    compare("int32", ints_per_element, ints_array);
+    free(floats_a);
+    free(floats_b);
+    free(doubles_a);
+    free(doubles_b);
+    free(ints_a);
+    free(ints_b);
+    return runit_at_least_one_fail;
+}
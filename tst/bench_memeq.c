@@ -0,0 +1,98 @@
+/**
+ * @file
+ * Throughput of comparing equal memory sections on a host, from 1 KB up to
+ * the given size: memcmp(), runit_mismatch_offset() and the pass path of
+ * runit_memeq(), which must stay as fast as memcmp().
+ *
+ * Also verifies that the first difference is found at the end of each size.
+ * The results are printed on stderr.
+ * Usage: runit-bench-memeq [largest size in MB, 1024 for 1 GB]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "runit.h"
+#include <stdlib.h> /* For malloc(), strtoul() */
+#include <time.h>   /* For clock_gettime() */
+
+/* Bytes compared per measurement, split into repetitions for small sizes. */
+#define BYTES_PER_RUN (256UL << 20U)
+
+static volatile size_t kept = 0;
+
+static void with_memcmp(const uint8_t* a, const uint8_t* b, size_t length)
+{
+    kept += memcmp(a, b, length) == 0;
+}
+
+static void with_mismatch_offset(const uint8_t* a, const uint8_t* b, size_t length)
+{
+    kept += runit_mismatch_offset(a, b, length);
+}
+
+static void with_memeq(const uint8_t* a, const uint8_t* b, size_t length)
+{
+    runit_memeq(a, b, length);
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Best of a few runs, in GB/s. */
+static double bench(void (*compare)(const uint8_t*, const uint8_t*, size_t),
+                    const uint8_t* a,
+                    const uint8_t* b,
+                    size_t         length)
+{
+    const unsigned long repeats = length < BYTES_PER_RUN ? BYTES_PER_RUN / length : 1UL;
+    double              best    = 0;
+
+    for (unsigned int run = 0; run < 3U; run++)
+    {
+        const double start   = now_seconds();
+        double       elapsed = 0;
+        for (unsigned long i = 0; i < repeats; i++)
+        {
+            compare(a, b, length);
+        }
+        elapsed = now_seconds() - start;
+        if (best == 0 || elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+    return (double) length * (double) repeats / best * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t   largest = (argc > 1 ? strtoul(argv[1], NULL, 10) : 64UL) << 20U;
+    uint8_t* const a       = malloc(largest);
+    uint8_t* const b       = malloc(largest);
+    int            ok      = a != NULL && b != NULL;
+
+    for (size_t i = 0; ok && i < largest; i++)
+    {
+        a[i] = (uint8_t) (i * 31U);
+        b[i] = a[i];
+    }
+    for (size_t length = 1024U; ok && length <= largest; length *= 4U)
+    {
+        fprintf(stderr,
+                "BENCH | %7lu KB | memcmp %6.2f GB/s | runit_mismatch_offset %6.2f GB/s | runit_memeq %6.2f GB/s\n",
+                (unsigned long) (length >> 10U),
+                bench(with_memcmp, a, b, length),
+                bench(with_mismatch_offset, a, b, length),
+                bench(with_memeq, a, b, length));
+        b[length - 1U] ^= 0xFFU;
+        ok = runit_mismatch_offset(a, b, length) == length - 1U;
+        b[length - 1U] ^= 0xFFU;
+    }
+    free(a);
+    free(b);
+    return !ok || runit_at_least_one_fail;
+}
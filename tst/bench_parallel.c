@@ -0,0 +1,143 @@
+/**
+ * @file
+ * Scaling of runit_main() with worker processes on a synthetic, CPU-bound
+ * suite of test cases, on a host.
+ *
+ * Runs the same suite with an increasing amount of jobs, verifies that the
+ * counters gathered from the workers are exact and prints the speedup on
+ * stderr. The wall time depends on whatever else the host runs, e.g. the
+ * other tests of `ctest -j`, so the efficiency is only checked on request:
+ * with a minimum such as 0.6, it fails below it with a CPU per job. The test
+ * output itself goes to /dev/null.
+ * Usage: runit-bench-parallel [iterations per test case] [minimum efficiency]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "runit.h"
+#include <stdint.h> /* For uint32_t */
+#include <stdlib.h> /* For strtoul(), strtod() */
+#include <time.h>   /* For clock_gettime() */
+#include <unistd.h> /* For sysconf() */
+
+#define BENCH_TESTS 64U
+
+static unsigned long iterations     = 1000000UL;
+static double        min_efficiency = 0.0; /* Speedup per job required with a CPU per job, 0 for none */
+
+/* Some integer work the compiler cannot remove: xorshift32 steps. */
+static uint32_t spin(uint32_t seed)
+{
+    for (unsigned long i = 0; i < iterations; i++)
+    {
+        seed ^= seed << 13U;
+        seed ^= seed >> 17U;
+        seed ^= seed << 5U;
+    }
+    return seed;
+}
+
+#define BENCH_TEST(n)                           \
+    RUNIT_TEST(test_spin_##n)                   \
+    {                                           \
+        runit_neq(spin((uint32_t) n + 1U), 0U); \
+    }
+
+#define BENCH_TEST_8(n) \
+    BENCH_TEST(n##0)    \
+    BENCH_TEST(n##1)    \
+    BENCH_TEST(n##2)    \
+    BENCH_TEST(n##3)    \
+    BENCH_TEST(n##4)    \
+    BENCH_TEST(n##5)    \
+    BENCH_TEST(n##6)    \
+    BENCH_TEST(n##7)
+
+BENCH_TEST_8(1)
+BENCH_TEST_8(2)
+BENCH_TEST_8(3)
+BENCH_TEST_8(4)
+BENCH_TEST_8(5)
+BENCH_TEST_8(6)
+BENCH_TEST_8(7)
+BENCH_TEST_8(8)
+
+// Verifies that failures in the workers reach the runner
+RUNIT_TEST(test_expected_failure)
+{
+    runit_fail();
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static int bench(unsigned long jobs, long cpus, double* serial)
+{
+    char   jobs_text[24];
+    char*  argv[] = {"runit-bench-parallel", "-j", jobs_text, NULL};
+    double start;
+    double elapsed;
+    int    result;
+
+    snprintf(jobs_text, sizeof(jobs_text), "%lu", jobs);
+    runit_counter_assert_passes   = 0;
+    runit_counter_assert_failures = 0;
+    runit_at_least_one_fail       = 0;
+    start                         = now_seconds();
+    result                        = runit_main(3, argv);
+    elapsed                       = now_seconds() - start;
+    if (jobs == 1)
+    {
+        *serial = elapsed;
+    }
+    fprintf(stderr,
+            "BENCH | jobs: %3lu | %u tests | %8.2f ms | speedup %5.2f | efficiency %5.1f %%\n",
+            jobs,
+            BENCH_TESTS + 1U,
+            elapsed * 1e3,
+            *serial / elapsed,
+            *serial / elapsed / (double) jobs * 100.0);
+    if (jobs > 1U && jobs <= (unsigned long) cpus && *serial / elapsed / (double) jobs < min_efficiency)
+    {
+        fprintf(stderr, "BENCH | jobs: %3lu | efficiency below %.0f %%\n", jobs, min_efficiency * 100.0);
+        return 0;
+    }
+    return result == 1 && runit_counter_assert_passes == BENCH_TESTS && runit_counter_assert_failures == 1U;
+}
+
+int main(int argc, char** argv)
+{
+    const long cpus   = sysconf(_SC_NPROCESSORS_ONLN);
+    double     serial = 0;
+    int        ok     = 1;
+
+    if (argc > 1)
+    {
+        iterations = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2)
+    {
+        min_efficiency = strtod(argv[2], NULL);
+    }
+    if (runit_test_count() != BENCH_TESTS + 1U || freopen("/dev/null", "w", stdout) == NULL)
+    {
+        return 1;
+    }
+    if (min_efficiency > 0.0 && cpus < 2)
+    {
+        fprintf(stderr, "BENCH | 1 CPU: scaling not checked, only the counters\n");
+    }
+    for (unsigned long jobs = 1; jobs <= BENCH_TESTS; jobs *= 2)
+    {
+        ok = bench(jobs, cpus, &serial) && ok;
+        if (jobs >= (unsigned long) cpus && jobs >= 4U)  // Always check a few workers
+        {
+            break;
+        }
+    }
+    return !ok;
+}
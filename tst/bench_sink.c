@@ -0,0 +1,90 @@
+/**
+ * @file
+ * Throughput of the built-in runit sinks, emitting failure records on a host.
+ *
+ * The records are written to /dev/null, the results are printed on stderr.
+ * Usage: runit-bench-sink [records]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "runit.h"
+#include <fcntl.h>  /* For open() */
+#include <stdint.h> /* For intptr_t */
+#include <stdlib.h> /* For strtoul() */
+#include <time.h>   /* For clock_gettime() */
+#include <unistd.h> /* For close() */
+
+static size_t discarded_bytes = 0;
+
+static void discard_sink(void* context, const char* record, size_t length)
+{
+    (void) context;
+    (void) record;
+    discarded_bytes += length;
+}
+
+static void fail_once(void)
+{
+    runit_fail();
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void bench(const char* name, runit_sink_t sink, void* context, unsigned long records)
+{
+    char         drained[RUNIT_RECORD_MAX];
+    size_t       bytes = 0;
+    const double start = now_seconds();
+    double       elapsed;
+
+    runit_set_sink(sink, context);
+    for (unsigned long i = 0; i < records; i++)
+    {
+        fail_once();
+        if (sink == runit_sink_ring)
+        {
+            bytes += runit_sink_ring_read(drained, sizeof(drained));  // Consumer keeping up
+        }
+    }
+    fflush(stdout);
+    elapsed = now_seconds() - start;
+    runit_set_sink(NULL, NULL);
+    if (sink == discard_sink)
+    {
+        bytes = discarded_bytes;
+    }
+    fprintf(stderr,
+            "BENCH | sink: %-7s | %lu records | %8.2f ms | %6.2f M records/s",
+            name,
+            records,
+            elapsed * 1e3,
+            (double) records / elapsed * 1e-6);
+    if (bytes > 0)
+    {
+        fprintf(stderr, " | %7.1f MB/s", (double) bytes / elapsed * 1e-6);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned long records = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000UL;
+    const int           null_fd = open("/dev/null", O_WRONLY);
+
+    if (null_fd < 0 || freopen("/dev/null", "w", stdout) == NULL)
+    {
+        return 1;
+    }
+    bench("discard", discard_sink, NULL, records);  // Formatting only
+    bench("stdout", runit_sink_stdout, NULL, records);
+    bench("fd", runit_sink_fd, (void*) (intptr_t) null_fd, records);
+    bench("ring", runit_sink_ring, NULL, records);
+    close(null_fd);
+    return runit_counter_assert_failures == 4U * records ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * Cost of the passing runit_eq() and runit_le() on a host, capturing the
+ * values for the failure message, compared with the former macros that
+ * checked the expression only.
+ *
+ * The results are printed on stderr.
+ * Usage: runit-bench-values [millions of elements]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "runit.h"
+#include <stdlib.h> /* For malloc(), strtoul() */
+#include <time.h>   /* For clock_gettime() */
+
+/* runit_eq() and runit_le() before the values were captured. */
+#define plain_eq(a, b) RUNIT_CHECK_(RUNIT_KIND_EQ, #a ", " #b, (a) == (b))
+#define plain_le(a, b) RUNIT_CHECK_(RUNIT_KIND_LE, #a ", " #b, (a) <= (b))
+
+static void check_plain(const int* integers, const double* reals, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        plain_eq(integers[i], (int) i);
+        plain_le(reals[i], 1.0);
+    }
+}
+
+static void check_values(const int* integers, const double* reals, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        runit_eq(integers[i], (int) i);
+        runit_le(reals[i], 1.0);
+    }
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Best of a few runs, in ns per assertion. */
+static double bench(const char* name,
+                    void (*check)(const int*, const double*, size_t),
+                    const int*    integers,
+                    const double* reals,
+                    size_t        count)
+{
+    const unsigned int passes = runit_counter_assert_passes;
+    double             best   = 0;
+
+    for (unsigned int run = 0; run < 5U; run++)
+    {
+        const double start   = now_seconds();
+        double       elapsed = 0;
+        check(integers, reals, count);
+        elapsed = now_seconds() - start;
+        if (best == 0 || elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+    fprintf(stderr,
+            "BENCH | %-6s | %lu elements | %8.2f ms | %5.2f ns per assertion | %u passes per check\n",
+            name,
+            (unsigned long) count,
+            best * 1e3,
+            best * 1e9 / (double) (2U * count),
+            (runit_counter_assert_passes - passes) / 5U);
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t  count    = (argc > 1 ? strtoul(argv[1], NULL, 10) : 4UL) * 1000000UL;
+    int* const    integers = malloc(count * sizeof(int));
+    double* const reals    = malloc(count * sizeof(double));
+    double        plain;
+    double        values;
+
+    if (integers == NULL || reals == NULL)
+    {
+        free(integers);
+        free(reals);
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        integers[i] = (int) i;
+        reals[i]    = (double) i / (double) count;
+    }
+    plain  = bench("plain", check_plain, integers, reals, count);
+    values = bench("values", check_values, integers, reals, count);
+    fprintf(stderr, "BENCH | values / plain %.2fx\n", values / plain);
+    free(integers);
+    free(reals);
+    return runit_at_least_one_fail;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * Throughput of runit_zeros() on a large cleared buffer, on a host, compared
+ * with the former implementation asserting every byte on its own.
+ *
+ * The results are printed on stderr.
+ * Usage: runit-bench-zeros [megabytes]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "runit.h"
+#include <stdlib.h> /* For calloc(), strtoul() */
+#include <time.h>   /* For clock_gettime() */
+
+/* runit_zeros() before the word-wide scan: one assertion per byte. */
+#define bytewise_zeros(x, len)                                                                \
+    do                                                                                        \
+    {                                                                                         \
+        for (size_t __runit_idx = 0; __runit_idx < (size_t) (len); __runit_idx++)             \
+        {                                                                                     \
+            RUNIT_CHECK_(RUNIT_KIND_ZEROS, #x ", " #len, ((uint8_t*) (x))[__runit_idx] == 0); \
+        }                                                                                     \
+    } while (0)
+
+static void check_bytewise(const uint8_t* buffer, size_t length)
+{
+    bytewise_zeros(buffer, length);
+}
+
+static void check_wordwise(const uint8_t* buffer, size_t length)
+{
+    runit_zeros(buffer, length);
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Best of a few runs, in GB/s. */
+static double bench(const char* name, void (*check)(const uint8_t*, size_t), const uint8_t* buffer, size_t length)
+{
+    const unsigned int passes = runit_counter_assert_passes;
+    double             best   = 0;
+
+    for (unsigned int run = 0; run < 5U; run++)
+    {
+        const double start   = now_seconds();
+        double       elapsed = 0;
+        check(buffer, length);
+        elapsed = now_seconds() - start;
+        if (best == 0 || elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+    fprintf(stderr,
+            "BENCH | %-8s | %lu MB | %8.2f ms | %7.2f GB/s | %u passes per check\n",
+            name,
+            (unsigned long) (length >> 20U),
+            best * 1e3,
+            (double) length / best * 1e-9,
+            (runit_counter_assert_passes - passes) / 5U);
+    return (double) length / best * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t   length = (argc > 1 ? strtoul(argv[1], NULL, 10) : 64UL) << 20U;
+    uint8_t* const buffer = calloc(length, 1U);
+    double         bytewise;
+    double         wordwise;
+
+    if (buffer == NULL)
+    {
+        return 1;
+    }
+    bytewise = bench("bytewise", check_bytewise, buffer, length);
+    wordwise = bench("wordwise", check_wordwise, buffer, length);
+    fprintf(stderr, "BENCH | speedup %.1fx\n", wordwise / bytewise);
+    free(buffer);
+    return runit_at_least_one_fail;
+}
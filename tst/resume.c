@@ -0,0 +1,163 @@
+/**
+ * @file
+ * Self-test of runit_resume() on a host, emulating the resets of a target:
+ * the state lives in a file mapped into memory instead of .noinit RAM, and a
+ * crash or a timeout "resets" by re-executing this program from the signal
+ * handler, or after a simulated HardFault. The run must go on after the test
+ * case that caused each reset, with the counters of the earlier executions.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "runit.h"
+#include <fcntl.h>    /* For open() */
+#include <signal.h>   /* For sigaction() */
+#include <stdlib.h>   /* For getenv(), setenv() */
+#include <string.h>   /* For memcpy(), memset(), strstr() */
+#include <sys/mman.h> /* For mmap() */
+#include <sys/time.h> /* For setitimer() */
+#include <unistd.h>   /* For execv(), ftruncate() */
+
+#define MAX_RESETS 4
+
+static char** arguments;
+static char   hardfault_printed;
+
+static int* volatile nowhere = NULL;
+
+RUNIT_TEST(test_before)
+{
+    runit_true(1);
+}
+
+RUNIT_TEST(test_crash)
+{
+    runit_true(1);
+    *nowhere = 1;  // Reset, noted as a SIGSEGV
+}
+
+RUNIT_TEST(test_between)
+{
+    runit_true(1);
+    runit_true(1);
+}
+
+RUNIT_TEST(test_hang)
+{
+    volatile unsigned int forever  = 1;
+    struct itimerval      watchdog = {{0, 0}, {0, 100000}};
+
+    setitimer(ITIMER_REAL, &watchdog, NULL);
+    while (forever)
+    {
+    }
+}
+
+static void restart(void)
+{
+    execv(arguments[0], arguments);
+    _exit(2);
+}
+
+RUNIT_TEST(test_hardfault)
+{  // What the HardFault_Handler() of runit does on a target, without the fault
+    const runit_fault_t fault = {0x08001A2CU, 0x08001A11U, 0x21000000U, 0x00000400U, 0x40000000U, 0U, 0U};
+
+    runit_true(1);
+    if (runit_fail_fault(&fault))
+    {
+        restart();
+    }
+    runit_fail();  // Printed instead of noted
+}
+
+RUNIT_TEST(test_after)
+{
+    runit_true(1);
+}
+
+/* The reset vector: notes the cause like a fault handler would, then starts over. */
+static void reset(const int signal)
+{
+    if (signal == SIGALRM)
+    {
+        const uint32_t cause[] = {100U, 100U, 0U};
+        runit_persist_cause(RUNIT_KIND_TIMEOUT, cause, 3U);
+    }
+    else
+    {
+        const uint32_t cause[] = {(uint32_t) signal};
+        runit_persist_cause(RUNIT_KIND_CRASH, cause, 1U);
+    }
+    restart();
+}
+
+/* Prints each line, noting the one of the HardFault after its reset. */
+static void print_sink(void* context, const char* record, size_t length)
+{
+    char line[RUNIT_RECORD_MAX];
+
+    (void) context;
+    memcpy(line, record, length);
+    line[length] = '\0';
+    if (strstr(line, "HARDFAULT | File: ") == line && strstr(line, "| PC: 0x08001A2C | LR: 0x08001A11 |") != NULL)
+    {
+        hardfault_printed = 1;
+    }
+    fwrite(record, 1, length, stdout);
+}
+
+int main(int argc, char** argv)
+{
+    const char* const   resets = getenv("RUNIT_RESUME_RESETS");
+    const int           count  = resets != NULL ? atoi(resets) : 0;
+    char                path[] = "runit-resume-XXXXXX";
+    char                number[12];
+    runit_persistent_t* state;
+    struct sigaction    action;
+    int                 file;
+
+    (void) argc;
+    arguments = argv;
+    if (count > MAX_RESETS)
+    {
+        return 1;  // Started over instead of going on
+    }
+    snprintf(number, sizeof(number), "%d", count + 1);
+    setenv("RUNIT_RESUME_RESETS", number, 1);
+    if (count == 0)
+    {
+        file = mkstemp(path);
+        setenv("RUNIT_RESUME_STATE", path, 1);
+    }
+    else
+    {
+        file = open(getenv("RUNIT_RESUME_STATE"), O_RDWR);
+    }
+    if (file < 0 || ftruncate(file, sizeof(runit_persistent_t)) != 0)
+    {
+        return 1;
+    }
+    state = mmap(NULL, sizeof(runit_persistent_t), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    close(file);
+    if (state == MAP_FAILED)
+    {
+        return 1;
+    }
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = reset;
+    action.sa_flags   = SA_NODEFER;  // Otherwise the signal stays blocked in the new program
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, NULL);
+    sigaction(SIGALRM, &action, NULL);
+    setvbuf(stdout, NULL, _IONBF, 0);  // Nothing left in a buffer at the reset
+    runit_set_sink(print_sink, NULL);
+
+    runit_run_from(runit_resume(state));
+    runit_report();
+    remove(getenv("RUNIT_RESUME_STATE"));
+
+    // 3 resets, each test case once: the crash, the timeout and the fault fail, the passes within them are lost
+    return count != 3 || runit_counter_assert_passes != 4U || runit_counter_assert_failures != 3U || !hardfault_printed
+           || runit_resume(state) != 0;
+}
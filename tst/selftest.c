@@ -4,7 +4,15 @@
  *
  */
 
+#if defined(__unix__) || defined(__APPLE__)
+#    define _POSIX_C_SOURCE 200809L /* For mkstemp() */
+#    include <fcntl.h>
+#    include <stdlib.h>
+#    include <unistd.h>
+#endif
+
 #include "runit.h"
+#include <float.h> /* For FLT_MAX */
 #include <stdint.h>
 
 static size_t expected_failures_counter = 0;
@@ -19,88 +27,169 @@ static void test_initially_no_test_have_failed(void)
     runit_eq(runit_at_least_one_fail, 0);
 }
 
-static void test_assert(void)
+RUNIT_TEST(test_assert)
 {
     runit_assert(1);
     SHOULD_FAIL(runit_assert(0));
 }
 
-static void test_true(void)
+RUNIT_TEST(test_true)
 {
     runit_true(1);
     SHOULD_FAIL(runit_true(0));
 }
 
-static void test_false(void)
+RUNIT_TEST(test_false)
 {
     runit_false(3000 < 0);
     runit_false(0);
     SHOULD_FAIL(runit_false(1));
 }
 
-static void test_eq(void)
+RUNIT_TEST(test_eq)
 {
     runit_eq(12, 12);
     runit_eq(12.0f, 12U);
     SHOULD_FAIL(runit_eq(100, 1));
 }
 
-static void test_neq(void)
+RUNIT_TEST(test_neq)
 {
     runit_neq(100, 1);
     SHOULD_FAIL(runit_neq(12, 12));
 }
 
-static void test_neq_casting(void)
+RUNIT_TEST(test_neq_casting)
 {
     SHOULD_FAIL(runit_neq(12.0f, 12U));
 }
 
-static void test_gt(void)
+struct bit_fields
+{
+    unsigned int       low  : 3;
+    unsigned long long wide : 40;
+};
+
+struct node
+{
+    int value;
+};
+
+RUNIT_TEST(test_eq_types)
+{
+    const char               letter   = 'x';
+    const int                array[2] = {1, 2};
+    const int* const         pointer  = array;
+    unsigned long long       big      = 1ULL << 63U;
+    unsigned int             calls    = 0;
+    struct bit_fields        bits     = {5U, 1ULL << 39U};
+    struct node              node     = {0};
+    const struct node* const node_p   = &node;
+    volatile int             reg      = 7;
+    volatile int* const      reg_p    = &reg;
+
+    runit_eq(letter, 'x');
+    runit_eq((_Bool) 1, 1);
+    runit_gt(big, 1);
+    runit_lt(-1.5f, 0.5f);
+    runit_eq(0.1L, 0.1L);
+    runit_eq(pointer, array);
+    runit_neq(pointer, NULL);
+    runit_lt(&array[0], &array[1]);
+    runit_eq(calls++, 0U);  // Evaluated once
+    runit_eq(calls, 1U);
+    runit_eq(bits.low, 5);  // Promoted to int
+    runit_gt(bits.wide, 1U);  // Not captured, compared as written
+    runit_neq(node_p, NULL);  // Pointers to structures are not captured either
+    runit_eq(node_p, &node);
+    runit_neq(reg_p, NULL);
+    runit_eq(*reg_p, 7);
+}
+
+RUNIT_TEST(test_eq_float_values)
+{
+    SHOULD_FAIL(runit_eq(0.5f, 0.25f));
+}
+
+RUNIT_TEST(test_eq_pointer_values)
+{
+    const void* const pointer = (const void*) (uintptr_t) 0x1000U;
+    SHOULD_FAIL(runit_eq(pointer, NULL));
+}
+
+static void compare_negative(void)
+{
+    runit_eq(-5, 3);
+}
+
+RUNIT_TEST(test_eq_values)
+{
+    static char output[RUNIT_SINK_RING_SIZE + 1U];
+    size_t      length;
+
+    runit_set_sink(runit_sink_ring, NULL);
+    expected_failures_counter++;
+    compare_negative();
+    runit_set_sink(NULL, NULL);
+    length         = runit_sink_ring_read(output, sizeof(output) - 1U);
+    output[length] = '\0';
+#if defined(RUNIT_TOKENIZED)
+    runit_eq(length, 6U + RUNIT_HAVE_VALUES * 6U * 4U);
+    runit_eq((unsigned char) output[5], RUNIT_HAVE_VALUES * 6U);
+#elif RUNIT_HAVE_VALUES
+    runit_assert(strstr(output, "FAIL | File: ") == output);
+    runit_assert(strstr(output, "| Test case: compare_negative | Values: -5, 3\n") != NULL);
+#else
+    runit_assert(strstr(output, "FAIL | File: ") == output);
+    runit_assert(strstr(output, "| Test case: compare_negative\n") != NULL);
+#endif
+}
+
+RUNIT_TEST(test_gt)
 {
     runit_gt(100, 1);
     SHOULD_FAIL(runit_gt(1, 100));
 }
 
-static void test_gt_equality(void)
+RUNIT_TEST(test_gt_equality)
 {
     SHOULD_FAIL(runit_gt(100, 100));
 }
 
-static void test_ge(void)
+RUNIT_TEST(test_ge)
 {
     runit_ge(100, 1);
     SHOULD_FAIL(runit_ge(1, 100));
 }
 
-static void test_ge_equality(void)
+RUNIT_TEST(test_ge_equality)
 {
     runit_ge(100, 100);
 }
 
-static void test_lt(void)
+RUNIT_TEST(test_lt)
 {
     runit_lt(1, 100);
     SHOULD_FAIL(runit_lt(100, 1));
 }
 
-static void test_lt_equality(void)
+RUNIT_TEST(test_lt_equality)
 {
     SHOULD_FAIL(runit_lt(100, 100));
 }
 
-static void test_le(void)
+RUNIT_TEST(test_le)
 {
     runit_le(1, 100);
     SHOULD_FAIL(runit_le(100, 1));
 }
 
-static void test_le_equality(void)
+RUNIT_TEST(test_le_equality)
 {
     runit_le(100, 100);
 }
 
-static void test_fapprox(void)
+RUNIT_TEST(test_fapprox)
 {
     runit_fapprox(1.0f, 1.0f);
     runit_fapprox(1.0f, 1U);
@@ -108,7 +197,7 @@ static void test_fapprox(void)
     SHOULD_FAIL(runit_fapprox(1.0f, 1.1f));
 }
 
-static void test_fdelta(void)
+RUNIT_TEST(test_fdelta)
 {
     runit_fdelta(1.0f, 1.0f, 0.01f);
     runit_fdelta(1.0f, 1.1f, 0.15f);
@@ -117,7 +206,7 @@ static void test_fdelta(void)
     SHOULD_FAIL(runit_fdelta(1.0f, 1.1f, 0.01f));
 }
 
-static void test_fdelta_negatives(void)
+RUNIT_TEST(test_fdelta_negatives)
 {
     runit_fdelta(-1.0f, -1.0f, 0.01f);
     runit_fdelta(-1.0f, -1.0f, -0.01f);
@@ -128,7 +217,7 @@ static void test_fdelta_negatives(void)
     SHOULD_FAIL(runit_fdelta(-1.0f, -1.1f, 0.01f));
 }
 
-static void test_dapprox(void)
+RUNIT_TEST(test_dapprox)
 {
     runit_dapprox(1.0, 1.0);
     runit_dapprox(1.0, 1U);
@@ -136,7 +225,7 @@ static void test_dapprox(void)
     SHOULD_FAIL(runit_dapprox(1.0, 1.1));
 }
 
-static void test_ddelta(void)
+RUNIT_TEST(test_ddelta)
 {
     runit_ddelta(1.0, 1.1, 0.15);
     runit_ddelta(1.0, 1.0, 0.01);
@@ -144,7 +233,7 @@ static void test_ddelta(void)
     SHOULD_FAIL(runit_ddelta(1.0, 1.1, 0.01));
 }
 
-static void test_ddelta_negatives(void)
+RUNIT_TEST(test_ddelta_negatives)
 {
     runit_ddelta(-1.0, -1.0, 0.01);
     runit_ddelta(-1.0, -1.0, -0.01);
@@ -155,94 +244,94 @@ static void test_ddelta_negatives(void)
     SHOULD_FAIL(runit_ddelta(-1.0, -1.1, 0.01));
 }
 
-static void test_nan(void)
+RUNIT_TEST(test_nan)
 {
     runit_nan(NAN);
     runit_nan(nan(""));
     runit_nan(nanf(""));
 }
 
-static void test_nan_finite_float(void)
+RUNIT_TEST(test_nan_finite_float)
 {
     SHOULD_FAIL(runit_nan(1.0f));
 }
 
-static void test_nan_finite_double(void)
+RUNIT_TEST(test_nan_finite_double)
 {
     SHOULD_FAIL(runit_nan(1.0));
 }
 
-static void test_nan_infinity(void)
+RUNIT_TEST(test_nan_infinity)
 {
     SHOULD_FAIL(runit_nan(INFINITY));
 }
 
-static void test_inf(void)
+RUNIT_TEST(test_inf)
 {
     runit_inf(INFINITY);
     runit_inf(+INFINITY);
     runit_inf(-INFINITY);
 }
 
-static void test_inf_finite_float(void)
+RUNIT_TEST(test_inf_finite_float)
 {
     SHOULD_FAIL(runit_inf(1.0f));
 }
 
-static void test_inf_finite_double(void)
+RUNIT_TEST(test_inf_finite_double)
 {
     SHOULD_FAIL(runit_inf(1.0));
 }
 
-static void test_inf_nan(void)
+RUNIT_TEST(test_inf_nan)
 {
     SHOULD_FAIL(runit_inf(NAN));
 }
 
-static void test_plusinf(void)
+RUNIT_TEST(test_plusinf)
 {
     runit_plusinf(INFINITY);
     runit_plusinf(+INFINITY);
     SHOULD_FAIL(runit_plusinf(-INFINITY));
 }
 
-static void test_plusinf_finite_float(void)
+RUNIT_TEST(test_plusinf_finite_float)
 {
     SHOULD_FAIL(runit_plusinf(1.0f));
 }
 
-static void test_plusinf_finite_double(void)
+RUNIT_TEST(test_plusinf_finite_double)
 {
     SHOULD_FAIL(runit_plusinf(1.0));
 }
 
-static void test_plusinf_nan(void)
+RUNIT_TEST(test_plusinf_nan)
 {
     SHOULD_FAIL(runit_plusinf(NAN));
 }
 
-static void test_minusinf(void)
+RUNIT_TEST(test_minusinf)
 {
     runit_minusinf(-INFINITY);
     SHOULD_FAIL(runit_minusinf(INFINITY));
 }
 
-static void test_minusinf_finite_float(void)
+RUNIT_TEST(test_minusinf_finite_float)
 {
     SHOULD_FAIL(runit_minusinf(1.0f));
 }
 
-static void test_minusinf_finite_double(void)
+RUNIT_TEST(test_minusinf_finite_double)
 {
     SHOULD_FAIL(runit_minusinf(1.0));
 }
 
-static void test_minusinf_nan(void)
+RUNIT_TEST(test_minusinf_nan)
 {
     SHOULD_FAIL(runit_minusinf(NAN));
 }
 
-static void test_notfinite(void)
+RUNIT_TEST(test_notfinite)
 {
     runit_notfinite(INFINITY);
     runit_notfinite(+INFINITY);
@@ -252,17 +341,17 @@ static void test_notfinite(void)
     runit_notfinite(nan(""));
 }
 
-static void test_notfinite_finite_float(void)
+RUNIT_TEST(test_notfinite_finite_float)
 {
     SHOULD_FAIL(runit_notfinite(1.0f));
 }
 
-static void test_notfinite_finite_double(void)
+RUNIT_TEST(test_notfinite_finite_double)
 {
     SHOULD_FAIL(runit_notfinite(1.0));
 }
 
-static void test_finite(void)
+RUNIT_TEST(test_finite)
 {
     runit_finite(0.0f);
     runit_finite(-0.0f);
@@ -274,32 +363,32 @@ static void test_finite(void)
     runit_finite(-1.0);
 }
 
-static void test_finite_plusinf(void)
+RUNIT_TEST(test_finite_plusinf)
 {
     SHOULD_FAIL(runit_finite(INFINITY));
 }
 
-static void test_finite_minusinf(void)
+RUNIT_TEST(test_finite_minusinf)
 {
     SHOULD_FAIL(runit_finite(-INFINITY));
 }
 
-static void test_finite_nan_macro(void)
+RUNIT_TEST(test_finite_nan_macro)
 {
     SHOULD_FAIL(runit_finite(NAN));
 }
 
-static void test_finite_nan_call(void)
+RUNIT_TEST(test_finite_nan_call)
 {
     SHOULD_FAIL(runit_finite(nan("")));
 }
 
-static void test_finite_nanf_call(void)
+RUNIT_TEST(test_finite_nanf_call)
 {
     SHOULD_FAIL(runit_finite(nanf("")));
 }
 
-static void test_flag(void)
+RUNIT_TEST(test_flag)
 {
     runit_flag(1, 1);
     runit_flag(0xFF, 1);
@@ -315,14 +404,14 @@ static void test_flag(void)
     SHOULD_FAIL(runit_flag(0x07, 0xF0));
 }
 
-static void test_flag_when_none(void)
+RUNIT_TEST(test_flag_when_none)
 {
     /* runit_flag() checks for flag presence. To check for their absence,
      * runit_noflag() should be used instead; or even runit_eq(flags, 0). */
     SHOULD_FAIL(runit_flag(0, 0));
 }
 
-static void test_noflag(void)
+RUNIT_TEST(test_noflag)
 {
     runit_noflag(0, 1);
     runit_noflag(2, 1);
@@ -335,7 +424,7 @@ static void test_noflag(void)
     SHOULD_FAIL(runit_noflag(0x07, 0x04));
 }
 
-static void test_streq(void)
+RUNIT_TEST(test_streq)
 {
     const char a[] = "hello";
     const char b[] = "hello";
@@ -353,7 +442,7 @@ static void test_streq(void)
     SHOULD_FAIL(runit_streq(a, c, 5));
 }
 
-static void test_memeq(void)
+RUNIT_TEST(test_memeq)
 {
     const uint8_t a[] = {255, 255, 255, 255, 255};
     const uint8_t b[] = {255, 255, 255, 255, 255};
@@ -371,7 +460,47 @@ static void test_memeq(void)
     SHOULD_FAIL(runit_memeq(c, a, 5));
 }
 
-static void test_memneq(void)
+// Every alignment of both sections and length around the word and vector
+// blocks, with one differing byte anywhere or none
+RUNIT_TEST(test_mismatch_offset)
+{
+    static uint8_t a[300];
+    static uint8_t b[300];
+    size_t         mismatches = 0;
+
+    for (size_t i = 0; i < sizeof(a); i++)
+    {
+        a[i] = (uint8_t) i;
+    }
+    for (size_t start = 0; start < 16U; start++)
+    {
+        const size_t start_b = (start * 5U) % 16U;
+        memcpy(&b[start_b], &a[start], sizeof(a) - 16U);
+        for (size_t length = 0; start + length <= 280U; length += 7U)
+        {
+            mismatches += runit_mismatch_offset(&a[start], &b[start_b], length) != length;
+            for (size_t at = 0; at < length; at++)
+            {
+                b[start_b + at] ^= 0x01U;
+                mismatches += runit_mismatch_offset(&a[start], &b[start_b], length) != at;
+                b[start_b + at] ^= 0x01U;
+            }
+        }
+    }
+    runit_eq(mismatches, 0U);
+    memcpy(b, a, sizeof(a));
+    b[150] = 0;
+    runit_memeq(a, b, 150U);
+    SHOULD_FAIL(runit_memeq(a, b, sizeof(a)));
+}
+
+// The window of bytes stays within short sections
+RUNIT_TEST(test_memeq_window)
+{
+    SHOULD_FAIL(runit_memeq("abcdefghij", "abcdefghiJ", 10U));
+}
+
+RUNIT_TEST(test_memneq)
 {
     const uint8_t a[] = {255, 255, 255, 255, 255};
     const uint8_t b[] = {255, 255, 255, 255, 255};
@@ -388,7 +517,7 @@ static void test_memneq(void)
     SHOULD_FAIL(runit_memneq(a, b, 5));
 }
 
-static void test_zeros(void)
+RUNIT_TEST(test_zeros)
 {
     const uint8_t  a[] = {0, 0, 0, 0, 0};
     const uint8_t  b[] = {0, 0, 255, 255, 255};
@@ -406,7 +535,33 @@ static void test_zeros(void)
     SHOULD_FAIL(runit_zeros(b, 5U));
 }
 
-static void test_nzeros(void)
+// Every alignment and length around the word and vector blocks, with one
+// non-zero byte anywhere or none
+RUNIT_TEST(test_nonzero_offset)
+{
+    static uint8_t buffer[300];
+    size_t         mismatches = 0;
+
+    for (size_t start = 0; start < 16U; start++)
+    {
+        for (size_t length = 0; start + length <= 280U; length += 7U)
+        {
+            mismatches += runit_nonzero_offset(&buffer[start], length) != length;
+            for (size_t at = 0; at < length; at++)
+            {
+                buffer[start + at] = 0x80;
+                mismatches += runit_nonzero_offset(&buffer[start], length) != at;
+                buffer[start + at] = 0;
+            }
+        }
+    }
+    runit_eq(mismatches, 0U);
+    buffer[299] = 1;
+    runit_zeros(buffer, 299U);
+    SHOULD_FAIL(runit_zeros(buffer, sizeof(buffer)));
+}
+
+RUNIT_TEST(test_nzeros)
 {
     const uint8_t a[] = {0, 0, 0, 0, 0};
     const uint8_t b[] = {0, 0, 255, 255, 255};
@@ -425,74 +580,709 @@ static void test_nzeros(void)
     SHOULD_FAIL(runit_nzeros(a, 5U));
 }
 
-static void test_fail(void)
+// Every length around the vector width, with one element out of tolerance
+// anywhere or none
+RUNIT_TEST(test_farray_delta)
+{
+    float  a[40];
+    float  b[40];
+    size_t mismatches = 0;
+
+    for (size_t i = 0; i < 40U; i++)
+    {
+        a[i] = (float) i * 0.5f;
+        b[i] = a[i] + 0.01f;
+    }
+    for (size_t count = 0; count <= 40U; count++)
+    {
+        mismatches += !runit_farray_within(a, b, count, 0.02f);
+        for (size_t at = 0; at < count; at++)
+        {
+            b[at] += 1.0f;
+            mismatches += runit_farray_within(a, b, count, 0.02f) != 0;
+            b[at] -= 1.0f;
+        }
+    }
+    runit_eq(mismatches, 0U);
+    runit_farray_delta(a, b, 40U, -0.02f);  // Sign of the tolerance ignored
+    b[3]  = 2.0f;
+    b[31] = 16.25f;
+    SHOULD_FAIL(runit_farray_delta(a, b, 40U, 0.02f));  // Worst is index 31
+}
+
+RUNIT_TEST(test_farray_delta_nan)
+{
+    const float a[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f};
+    const float b[] = {1.0f, 2.0f, 3.0f, 4.0f, NAN};
+
+    runit_farray_delta(a, b, 4U, 0.0f);
+    SHOULD_FAIL(runit_farray_delta(a, b, 5U, 1000.0f));
+}
+
+RUNIT_TEST(test_darray_delta)
+{
+    double a[21];
+    double b[21];
+    size_t mismatches = 0;
+
+    for (size_t i = 0; i < 21U; i++)
+    {
+        a[i] = (double) i * 0.25;
+        b[i] = a[i] - 1e-9;
+    }
+    for (size_t count = 0; count <= 21U; count++)
+    {
+        mismatches += !runit_darray_within(a, b, count, 1e-8);
+        for (size_t at = 0; at < count; at++)
+        {
+            b[at] = NAN;
+            mismatches += runit_darray_within(a, b, count, 1e-8) != 0;
+            b[at] = a[at] - 1e-9;
+        }
+    }
+    runit_eq(mismatches, 0U);
+    runit_darray_delta(a, b, 21U, 1e-8);
+    b[20] = 1.0;
+    SHOULD_FAIL(runit_darray_delta(a, b, 21U, 1e-8));
+}
+
+// Next representable value away from zero, without libm
+static float next_float(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits++;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+static double next_double(double x)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits++;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+RUNIT_TEST(test_fulp)
+{
+    runit_fulp(1.0f, 1.0f, 0U);
+    runit_fulp(0.0f, -0.0f, 0U);
+    runit_fulp(1e9f, 1e9f + 64.0f, 1U);  // Next float
+    runit_fulp(1e-9f, next_float(next_float(1e-9f)), 2U);
+    runit_fulp(-1e-45f, 1e-45f, 2U);  // Smallest subnormals, across zero
+    runit_fulp(FLT_MAX, INFINITY, 1U);
+    runit_eq(runit_fulp_distance(1.0f, NAN), UINT32_MAX);
+    runit_eq(runit_fulp_distance(-INFINITY, INFINITY), 0xFF000000U);
+    runit_fulp(0.1f + 0.2f, 0.3f, 1U);
+    SHOULD_FAIL(runit_fulp(1.0f, 1.001f, 4U));
+}
+
+RUNIT_TEST(test_dulp)
+{
+    runit_dulp(0.1 + 0.2, 0.3, 1U);
+    runit_dulp(-0.0, 0.0, 0U);
+    runit_dulp(1e300, next_double(1e300), 1U);
+    runit_eq(runit_dulp_distance(NAN, NAN), UINT64_MAX);
+    runit_eq(runit_dulp_distance(-INFINITY, INFINITY), 0xFFE0000000000000U);
+    SHOULD_FAIL(runit_dulp(1.0, 1.0001, 4U));
+}
+
+// Every length around the block of the kernels, with one element too far
+// anywhere or none
+RUNIT_TEST(test_array_ulp)
+{
+    float  a[40];
+    float  b[40];
+    double c[40];
+    double d[40];
+    size_t mismatches = 0;
+
+    for (size_t i = 0; i < 40U; i++)
+    {
+        a[i] = (float) i * -1e7f;
+        b[i] = next_float(a[i]);
+        c[i] = (double) i * 1e-300;
+        d[i] = next_double(c[i]);
+    }
+    for (size_t count = 0; count <= 40U; count++)
+    {
+        mismatches += !runit_farray_ulp_within(a, b, count, 1U);
+        mismatches += !runit_darray_ulp_within(c, d, count, 1U);
+        for (size_t at = 0; at < count; at++)
+        {
+            const float  saved_b = b[at];
+            const double saved_d = d[at];
+            b[at]                = at % 2U ? NAN : -a[at] - 1.0f;
+            d[at]                = at % 2U ? (double) NAN : next_double(d[at]);
+            mismatches += runit_farray_ulp_within(a, b, count, 1U) != 0;
+            mismatches += runit_darray_ulp_within(c, d, count, 1U) != 0;
+            b[at] = saved_b;
+            d[at] = saved_d;
+        }
+    }
+    runit_eq(mismatches, 0U);
+    runit_farray_ulp(a, b, 40U, 1U);
+    runit_darray_ulp(c, d, 40U, 1U);
+    b[17] = next_float(next_float(b[17]));
+    SHOULD_FAIL(runit_farray_ulp(a, b, 40U, 2U));
+}
+
+RUNIT_TEST(test_darray_ulp)
+{
+    const double a[] = {1.0, 2.0, 3.0};
+    const double b[] = {1.0, 2.0000000000000004, 3.0000000000000018};
+
+    runit_darray_ulp(a, b, 2U, 1U);
+    SHOULD_FAIL(runit_darray_ulp(a, b, 3U, 1U));
+}
+
+RUNIT_TEST(test_rel_close)
+{
+    runit_frel(1e9f, 1.0001e9f, 1e-3f);
+    runit_frel(-1e-9f, -1.0001e-9f, 1e-3f);
+    runit_frel(INFINITY, INFINITY, 0.0f);
+    runit_drel(1e-300, 1.0000001e-300, 1e-6);
+    runit_fclose(0.0f, 1e-7f, 1e-6f, 1e-5f);
+    runit_fclose(1e9f, 1.000001e9f, 1e-6f, 1e-5f);
+    runit_dclose(0.0, -1e-12, 1e-9, 1e-9);
+    runit_dclose(1e12, 1e12 + 1.0, 1e-9, 1e-9);
+    runit_false(runit_fclose_within(NAN, NAN, 1.0f, 1.0f));
+    runit_false(runit_dclose_within(1e-9, 1.1e-9, 0.0, 1e-3));
+    SHOULD_FAIL(runit_frel(1e-9f, 1.1e-9f, 1e-3f));
+}
+
+RUNIT_TEST(test_dclose)
+{
+    SHOULD_FAIL(runit_dclose(1.0, 1.1, 1e-6, 1e-5));
+}
+
+RUNIT_TEST(test_array_eq)
+{
+    const int16_t a[] = {1, 2, 3, 4, 5};
+    const int16_t b[] = {1, 2, 3, 4, -5};
+
+    runit_array_eq(a, b, 0U);
+    runit_array_eq(a, b, 4U);
+    runit_array_eq("abc", "abd", 2U);
+    SHOULD_FAIL(runit_array_eq(a, b, 5U));
+}
+
+RUNIT_TEST(test_array_eq_64)
+{
+    const uint64_t a[] = {1, 2, 3};
+    const uint64_t b[] = {1, 2, 0xFFFFFFFF00000003U};
+
+    runit_array_eq(a, b, 2U);
+    SHOULD_FAIL(runit_array_eq(a, b, 3U));
+}
+
+RUNIT_TEST(test_fail)
 {
     SHOULD_FAIL(runit_fail());
 }
 
+RUNIT_TEST(test_sites)
+{
+#if RUNIT_HAVE_SITE_SECTION
+    size_t              fail_sites = 0;
+    const runit_site_t* site;
+
+    runit_gt(runit_site_count(), 100U);
+    for (site = runit_sites_begin(); site != runit_sites_end(); site++)
+    {
+        runit_true(site->file != NULL && site->function != NULL && site->expression != NULL);
+        runit_lt(site->kind, RUNIT_KIND_COUNT);
+        if (site->kind == RUNIT_KIND_FAIL && strcmp(site->function, "test_fail") == 0)
+        {
+            fail_sites++;
+        }
+    }
+    runit_eq(fail_sites, 1U);
+#else
+    runit_eq(runit_site_count(), 0U);
+#endif
+}
+
+RUNIT_TEST(test_filename)
+{
+    const char   expected[] = "selftest.c";
+    const size_t length     = strlen(RUNIT_FILENAME);
+
+    runit_ge(length, sizeof(expected) - 1);
+    runit_streq(RUNIT_FILENAME + length - (sizeof(expected) - 1), expected, sizeof(expected));
+#if defined(RUNIT_NO_FULL_PATH)
+    runit_streq(RUNIT_FILENAME, expected, sizeof(expected));
+#endif
+}
+
+static void fail_silently(void)
+{
+    expected_failures_counter++;
+    runit_fail();
+}
+
+static size_t counting_sink_calls = 0;
+
+static void counting_sink(void* context, const char* record, size_t length)
+{
+    (void) record;
+    counting_sink_calls++;
+    *(size_t*) context += length;
+}
+
+RUNIT_TEST(test_sink_custom)
+{
+    size_t total_length = 0;
+
+    counting_sink_calls = 0;
+    runit_set_sink(counting_sink, &total_length);
+    fail_silently();
+    fail_silently();
+    runit_set_sink(NULL, NULL);
+    runit_eq(counting_sink_calls, 2U);  // One call per record
+    runit_gt(total_length, 0U);
+}
+
+RUNIT_TEST(test_sink_ring)
+{
+    char   record[RUNIT_RECORD_MAX];
+    size_t length;
+
+    runit_set_sink(runit_sink_ring, NULL);
+    fail_silently();
+    runit_set_sink(NULL, NULL);
+    length = runit_sink_ring_read(record, sizeof(record));
+    runit_gt(length, 0U);
+    runit_lt(length, sizeof(record));
+#if defined(RUNIT_TOKENIZED)
+    runit_eq((unsigned char) record[0], RUNIT_TOKEN_MARKER);
+    runit_eq(length, 6U);
+#else
+    runit_memeq(record, "FAIL | File: ", 13U);
+    runit_eq(record[length - 1U], '\n');
+#endif
+    runit_eq(runit_sink_ring_read(record, sizeof(record)), 0U);
+    runit_eq(runit_sink_ring_dropped(), 0U);
+}
+
+#if RUNIT_HAVE_SINK_FD && (defined(__unix__) || defined(__APPLE__))
+// A full non-blocking pipe drops the record instead of spinning forever
+RUNIT_TEST(test_sink_fd_full)
+{
+    static const char chunk[4096] = {0};
+    int               fds[2];
+
+    runit_eq(pipe(fds), 0);
+    runit_eq(fcntl(fds[1], F_SETFL, O_NONBLOCK), 0);
+    while (write(fds[1], chunk, sizeof(chunk)) > 0)
+    {
+    }
+    runit_sink_fd((void*) (intptr_t) fds[1], "FAIL | Dropped\n", 15U);
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif
+
+RUNIT_TEST(test_deferred)
+{
+    size_t total_length = 0;
+
+    counting_sink_calls = 0;
+    runit_set_sink(counting_sink, &total_length);
+    runit_set_deferred(1);
+    fail_silently();
+    fail_silently();
+    fail_silently();
+    runit_eq(counting_sink_calls, 0U);  // Nothing sent yet
+    runit_eq(runit_flush(), 3U);
+    runit_eq(counting_sink_calls, 3U);
+    runit_eq(runit_flush(), 0U);
+    for (unsigned int i = 0; i < RUNIT_DEFERRED_CAPACITY + 2U; i++)
+    {
+        fail_silently();
+    }
+    runit_set_deferred(0);  // Flushes too
+    runit_set_sink(NULL, NULL);
+    runit_eq(counting_sink_calls, 3U + RUNIT_DEFERRED_CAPACITY);
+    runit_eq(runit_deferred_overflows(), 2U);
+}
+
+RUNIT_TEST(test_clock_extend32)
+{
+    uint64_t extended = 0;
+
+    runit_eq(runit_clock_extend32(&extended, 0xFFFFFFF0U), 0xFFFFFFF0U);
+    runit_eq(runit_clock_extend32(&extended, 0x10U), 0x100000010U);  // Wrapped
+    runit_eq(runit_clock_extend32(&extended, 0x20U), 0x100000020U);
+    runit_eq(runit_clock_extend32(&extended, 0x20U), 0x100000020U);  // Stopped
+    runit_eq(runit_clock_extend32(&extended, 0x5U), 0x200000005U);
+    runit_eq(extended, 0x200000005U);
+}
+
+RUNIT_TEST(test_clock_overhead)
+{
+    uint64_t start = runit_clock_now();
+
+    runit_lt(runit_clock_overhead(), 1000000U);  // Way less than 1 ms
+    runit_ge(runit_clock_now(), start);
+#if RUNIT_HAVE_CLOCK_RDTSC
+    runit_set_clock(runit_clock_rdtsc, "cycles");
+    start = runit_clock_now();
+    runit_lt(runit_clock_overhead(), 100000U);
+    runit_gt(runit_clock_now(), start);
+    runit_set_clock(NULL, NULL);
+#endif
+}
+
+static void busy_loop(unsigned int iterations)
+{
+    for (volatile unsigned int i = 0; i < iterations; i++)
+    {
+    }
+}
+
+static void exceed_time_budget(void)
+{
+    runit_max_ns(0U, RUNIT_MIN, 3U, busy_loop(10000U));
+}
+
+RUNIT_TEST(test_expect)
+{
+    unsigned int reached = 0;
+
+    runit_expect_true(1);
+    runit_expect_eq(12, 12);
+    runit_expect_memeq("abcd", "abcd", 4);
+    SHOULD_FAIL(runit_expect_eq(100, 1));
+    SHOULD_FAIL(runit_expect_fdelta(1.0f, 1.1f, 0.01f));
+    SHOULD_FAIL(runit_expect_memeq("abcd", "abCD", 4));
+    SHOULD_FAIL(runit_expect_zeros("\0\0cd", 4));
+    reached = 1;
+    runit_eq(reached, 1U);  // The test case went on
+}
+
+RUNIT_TEST(test_expect_max)
+{
+    static char output[RUNIT_SINK_RING_SIZE + 1U];
+    size_t      length;
+
+    runit_set_sink(runit_sink_ring, NULL);
+    for (unsigned int i = 0; i < RUNIT_EXPECT_MAX + 4U; i++)
+    {
+        expected_failures_counter++;
+        runit_expect_gt(i, RUNIT_EXPECT_MAX + 4U);
+    }
+    runit_set_sink(NULL, NULL);
+    length         = runit_sink_ring_read(output, sizeof(output) - 1U);
+    output[length] = '\0';
+#if defined(RUNIT_TOKENIZED)
+    runit_eq(length, RUNIT_EXPECT_MAX * (6U + RUNIT_HAVE_VALUES * 6U * 4U));
+#else
+    size_t lines = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        lines += output[i] == '\n';
+    }
+    runit_eq(lines, RUNIT_EXPECT_MAX);
+#endif
+}
+
+RUNIT_TEST(test_max_ns)
+{
+    static char output[RUNIT_SINK_RING_SIZE + 1U];
+    size_t      length;
+
+    runit_max_ns(100000000U, RUNIT_MEDIAN, 5U, busy_loop(10U));  // Way less than 100 ms
+    runit_max_ns(100000000U, RUNIT_P95, 100U, {
+        busy_loop(10U);
+        busy_loop(20U);
+    });
+#if RUNIT_HAVE_CLOCK_CYCLES
+    runit_max_cycles(1000000000U, RUNIT_MIN, 3U, busy_loop(10U));
+#endif
+    runit_set_sink(runit_sink_ring, NULL);
+    expected_failures_counter++;
+    exceed_time_budget();
+    runit_set_sink(NULL, NULL);
+    length         = runit_sink_ring_read(output, sizeof(output) - 1U);
+    output[length] = '\0';
+#if defined(RUNIT_TOKENIZED)
+    runit_eq(length, 6U + 4U * 4U);
+    runit_eq((unsigned char) output[5], 4U);
+#else
+    runit_assert(strstr(output, "| Test case: exceed_time_budget | Min of 3: ") != NULL);
+    runit_assert(strstr(output, " ns > 0 ns\n") != NULL);
+#endif
+}
+
+RUNIT_TEST(test_bench_statistics)
+{
+    uint64_t            samples[] = {500U, 100U, 300U, 200U, 400U};  // 10 iterations each
+    runit_bench_stats_t stats;
+
+    runit_bench_statistics(samples, 5U, 10U, &stats);
+    runit_eq(samples[0], 100U);  // Sorted
+    runit_eq(samples[4], 500U);
+    runit_eq(stats.samples, 5U);
+    runit_eq(stats.iterations, 10U);
+    runit_eq(stats.min, 1000U);  // 10.00 per iteration
+    runit_eq(stats.median, 3000U);
+    runit_eq(stats.mean, 3000U);
+    runit_eq(stats.p99, 5000U);
+    runit_eq(stats.stddev, 1581U);  // sqrt(100000 / 4) / 10
+}
+
+RUNIT_TEST(test_bench_memcmp)
+{
+    static unsigned char a[256];
+    static unsigned char b[256];
+    uint64_t             samples[10];
+    char                 record[RUNIT_RECORD_MAX];
+    size_t               length;
+    unsigned long        iterations = 0;
+
+    runit_set_sink(runit_sink_ring, NULL);
+    RUNIT_BENCH_INTO(memcmp_256, samples, 10U)
+    {
+        RUNIT_BENCH_KEEP(memcmp(a, b, sizeof(a)));
+        iterations++;
+    }
+    runit_set_sink(NULL, NULL);
+    length = runit_sink_ring_read(record, sizeof(record));
+    runit_gt(iterations, 10U + RUNIT_BENCH_WARMUP);
+    runit_le(samples[0], samples[9]);  // Sorted by the statistics
+    runit_gt(length, 0U);
+#if defined(RUNIT_TOKENIZED)
+    runit_eq((unsigned char) record[0], RUNIT_TOKEN_MARKER);
+    runit_eq(length, 6U + 7U * 4U);
+#else
+    runit_memeq(record, "BENCH | File: ", 14U);
+    runit_eq(record[length - 1U], '\n');
+#endif
+}
+
+#if defined(__GNUC__)
+// A single statement: the benchmark is the body of the if
+RUNIT_TEST(test_bench_single_statement)
+{
+    uint64_t     samples[10];
+    unsigned int runs = 0;
+
+    if (runs > 0U)
+        RUNIT_BENCH_INTO(never, samples, 10U)
+        {
+            runs++;
+        }
+    runit_eq(runs, 0U);
+}
+#endif
+
+RUNIT_TEST(test_bench_compare)
+{
+    uint64_t                 baseline[100];
+    uint64_t                 current[100];
+    runit_bench_comparison_t comparison;
+
+    for (unsigned int i = 0; i < 100U; i++)
+    {
+        baseline[i] = 100U + i;
+        current[i]  = baseline[i];
+    }
+    runit_false(runit_bench_compare(baseline, 100U, current, 100U, &comparison));
+    runit_eq(comparison.baseline_median, 149U);
+    runit_eq(comparison.median, 149U);
+    runit_ddelta(comparison.z, 0.0, 1e-9);
+    for (unsigned int i = 0; i < 100U; i++)
+    {
+        current[i] = baseline[i] * 3U / 2U;
+    }
+    runit_true(runit_bench_compare(baseline, 100U, current, 100U, &comparison));
+    runit_eq(comparison.median, 224U);
+    runit_gt(comparison.z, 5.0);
+    for (unsigned int i = 0; i < 100U; i++)
+    {
+        current[i] = baseline[i] + 5U;  // Significant, but below the threshold
+    }
+    runit_false(runit_bench_compare(baseline, 100U, current, 100U, NULL));
+    for (unsigned int i = 0; i < 10U; i++)
+    {
+        current[i] = i < 5U ? 50U : 300U;  // Slower median, but just noise
+    }
+    runit_false(runit_bench_compare(baseline, 100U, current, 10U, &comparison));
+    runit_eq(comparison.median, 175U);
+}
+
+static uint64_t fake_time = 0;
+
+static uint64_t fake_clock(void)
+{
+    return fake_time;
+}
+
+static void bench_fake_clock(uint64_t cost)
+{
+    uint64_t samples[20];
+
+    RUNIT_BENCH_INTO(fake, samples, 20U)
+    {
+        fake_time += cost;
+    }
+}
+
+RUNIT_TEST(test_bench_baseline)
+{
+    static char  output[RUNIT_SINK_RING_SIZE + 1U];
+    char         path[] = "runit-selftest-baseline-XXXXXX";
+    unsigned int failures;
+    size_t       length;
+
+    runit_counters_merge();
+    failures = runit_counter_assert_failures;
+#if defined(__unix__) || defined(__APPLE__)
+    close(mkstemp(path));
+#endif
+    runit_set_clock(fake_clock, "ticks");
+    runit_set_sink(runit_sink_ring, NULL);
+    runit_bench_set_baseline(path, 1);
+    bench_fake_clock(1000U);  // Writes the baseline
+    runit_bench_set_baseline(path, 0);
+    bench_fake_clock(1000U);  // Same speed: a pass
+    bench_fake_clock(2000U);  // Twice as slow: a failure
+    expected_failures_counter++;
+    runit_bench_set_baseline(NULL, 0);
+    runit_set_sink(NULL, NULL);
+    runit_set_clock(NULL, NULL);
+    remove(path);
+    runit_counters_merge();
+    runit_eq(runit_counter_assert_failures, failures + 1U);
+    length         = runit_sink_ring_read(output, sizeof(output) - 1U);
+    output[length] = '\0';
+#if defined(RUNIT_TOKENIZED)
+    runit_eq(length, 3U * (6U + 7U * 4U) + 6U + 3U * 4U);  // 3 results, 1 regression
+    runit_eq((unsigned char) output[3U * (6U + 7U * 4U) + 5U], 3U);
+#else
+    runit_assert(strstr(output, "BENCH | File: ") == output);
+    runit_assert(strstr(output, "| Regression: fake | Median: 1000.00 -> 2000.00 | z: ") != NULL);
+#endif
+}
+
+RUNIT_TEST(test_registration)
+{
+    const runit_test_t* found = NULL;
+
+    for (const runit_test_t* test = runit_tests_begin(); test != runit_tests_end(); test++)
+    {
+        if (strcmp(test->name, "test_fail") == 0)
+        {
+            found = test;
+        }
+    }
+    runit_ge(runit_test_count(), 50U);
+    runit_assert(found != NULL);
+    runit_assert(found->function == test_fail);
+    runit_streq(found->file, RUNIT_SITE_FILE, strlen(RUNIT_SITE_FILE) + 1U);
+    runit_gt(found->line, 0U);
+}
+
+#if RUNIT_HAVE_CRASH_RECOVERY
+static int* volatile nowhere = NULL;
+
+// Caught by runit_set_crash_recovery(), the following test cases still run
+RUNIT_TEST(test_crash)
+{
+    expected_failures_counter++;
+    printf("Expected failure: ");
+    *nowhere = 1;
+    runit_fail();  // Not reached
+}
+
+static unsigned int recurse(volatile unsigned int depth)
+{
+    volatile char frame[256];
+
+    frame[0] = (char) depth;
+    return depth == 0 ? 0U : recurse(depth + 1U) + (unsigned int) frame[0];
+}
+
+// Handled on the alternate stack, since the stack itself is full
+RUNIT_TEST(test_crash_stack_overflow)
+{
+    expected_failures_counter++;
+    printf("Expected failure: ");
+    runit_eq(recurse(1U), 0U);
+}
+#endif
+
+// Registers as a Cortex-M HardFault_Handler() would capture them, on any host
+static const runit_fault_t fault = {
+    0x08001A2CU, 0x08001A11U, 0x21000003U, 0x00008200U, 0x40000000U, 0xE000EDF8U, 0x20010000U};
+
+RUNIT_TEST(test_hardfault)
+{
+    expected_failures_counter++;
+    printf("Expected failure: ");
+    runit_eq(runit_fail_fault(&fault), 0);  // Printed at once without runit_resume()
+}
+
+static void test_hardfault_outside_test_cases(void)
+{
+    expected_failures_counter++;
+    printf("Expected failure: ");
+    runit_eq(runit_fail_fault(&fault), 0);
+}
+
 static void test_at_the_end_some_tests_have_failed(void)
 {
     runit_eq(runit_at_least_one_fail, 1);
 }
 
+// After runit_run_all(): every test case has a duration by now
+static void test_report_times(void)
+{
+    static char output[RUNIT_SINK_RING_SIZE + 1U];
+    size_t      timed = 0;
+    size_t      slowest;
+    size_t      length;
+
+    for (size_t i = 0; i < runit_test_count(); i++)
+    {
+        timed += runit_test_time(i) > 0;
+    }
+    runit_gt(timed, 0U);
+    runit_eq(runit_test_time(runit_test_count()), 0U);
+    slowest = timed < RUNIT_SLOWEST ? timed : RUNIT_SLOWEST;
+    runit_set_sink(runit_sink_ring, NULL);
+    runit_report_times();
+    runit_set_sink(NULL, NULL);
+    length         = runit_sink_ring_read(output, sizeof(output) - 1U);
+    output[length] = '\0';
+#if defined(RUNIT_TOKENIZED)
+    runit_eq(length, slowest * (6U + 2U * 4U) + (6U + 5U * 4U) + (6U + RUNIT_HISTOGRAM_BUCKETS * 4U));
+    runit_eq((unsigned char) output[slowest * (6U + 2U * 4U) + 5U], 5U);
+#else
+    size_t lines = 0;
+    for (const char* line = output; (line = strstr(line, "SLOWEST | File: ")) != NULL; line++)
+    {
+        lines++;
+    }
+    runit_eq(lines, slowest);
+    runit_assert(strstr(output, "TIMES | Test cases: ") != NULL);
+#endif
+}
+
 int main(void)
 {
+    // These four depend on the order, the others do not
     test_initially_no_test_have_failed();
-    test_assert();
-    test_true();
-    test_false();
-    test_eq();
-    test_neq();
-    test_neq_casting();
-    test_gt();
-    test_gt_equality();
-    test_ge();
-    test_ge_equality();
-    test_lt();
-    test_lt_equality();
-    test_le();
-    test_le_equality();
-    test_fapprox();
-    test_fdelta();
-    test_fdelta_negatives();
-    test_dapprox();
-    test_ddelta();
-    test_ddelta_negatives();
-    test_nan();
-    test_nan_finite_float();
-    test_nan_finite_double();
-    test_nan_infinity();
-    test_inf();
-    test_inf_finite_float();
-    test_inf_finite_double();
-    test_inf_nan();
-    test_plusinf();
-    test_plusinf_finite_float();
-    test_plusinf_finite_double();
-    test_plusinf_nan();
-    test_minusinf();
-    test_minusinf_finite_float();
-    test_minusinf_finite_double();
-    test_minusinf_nan();
-    test_notfinite();
-    test_notfinite_finite_float();
-    test_notfinite_finite_double();
-    test_finite();
-    test_finite_plusinf();
-    test_finite_minusinf();
-    test_finite_nan_macro();
-    test_finite_nanf_call();
-    test_finite_nan_call();
-    test_flag();
-    test_flag_when_none();
-    test_noflag();
-    test_streq();
-    test_memeq();
-    test_memneq();
-    test_zeros();
-    test_nzeros();
-    test_fail();
+    test_hardfault_outside_test_cases();
+#if RUNIT_HAVE_CRASH_RECOVERY
+    runit_set_crash_recovery(1);
+#endif
+    runit_run_all();
     test_at_the_end_some_tests_have_failed();
+    test_report_times();
     runit_report();
 
     // This self-test should generate a very precise amount of expected
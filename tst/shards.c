@@ -0,0 +1,174 @@
+/**
+ * @file
+ * Self-test of the sharding: over all shards of a given count, each test case
+ * must run exactly once, dealt out in order or balanced by the durations of a
+ * file, selected by code, by the runit_main() options or by the environment.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "runit.h"
+#include <stdlib.h> /* For setenv(), unsetenv(), mkstemp() */
+#include <unistd.h> /* For close() */
+
+#define SHARD_TESTS 23U
+
+/* Test cases beyond the balanced plan, dealt out in order. */
+#define UNPLANNED (SHARD_TESTS > RUNIT_TIMES_CAPACITY ? SHARD_TESTS - RUNIT_TIMES_CAPACITY : 0U)
+
+static unsigned int runs[SHARD_TESTS];
+
+#define SHARD_TEST(n)          \
+    RUNIT_TEST(test_shard_##n) \
+    {                          \
+        runs[n]++;             \
+    }
+
+SHARD_TEST(0)
+SHARD_TEST(1)
+SHARD_TEST(2)
+SHARD_TEST(3)
+SHARD_TEST(4)
+SHARD_TEST(5)
+SHARD_TEST(6)
+SHARD_TEST(7)
+SHARD_TEST(8)
+SHARD_TEST(9)
+SHARD_TEST(10)
+SHARD_TEST(11)
+SHARD_TEST(12)
+SHARD_TEST(13)
+SHARD_TEST(14)
+SHARD_TEST(15)
+SHARD_TEST(16)
+SHARD_TEST(17)
+SHARD_TEST(18)
+SHARD_TEST(19)
+SHARD_TEST(20)
+SHARD_TEST(21)
+SHARD_TEST(22)
+
+static const size_t counts[] = {1U, 2U, 3U, 8U, SHARD_TESTS, SHARD_TESTS + 5U};
+
+static void discard_sink(void* context, const char* record, size_t length)
+{
+    (void) context;
+    (void) record;
+    (void) length;
+}
+
+/* Each test case ran exactly once since the last call. */
+static void check_once(void)
+{
+    for (size_t i = 0; i < SHARD_TESTS; i++)
+    {
+        runit_eq(runs[i], 1U);
+        runs[i] = 0;
+    }
+}
+
+static void test_in_order(void)
+{
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        size_t total = 0;
+        for (size_t index = 0; index < counts[c]; index++)
+        {
+            runit_eq(runit_set_shard(index, counts[c], NULL), 0);
+            total += runit_run_all();
+        }
+        runit_eq(total, SHARD_TESTS);
+        check_once();
+    }
+    runit_eq(runit_set_shard(3U, 3U, NULL), -1);
+    runit_eq(runit_set_shard(0U, 0U, NULL), -1);
+}
+
+static void test_balanced(const char* const times)
+{
+    FILE* const file = fopen(times, "w");
+
+    // One test case takes as long as all the others together and more
+    runit_assert(file != NULL);
+    fprintf(file, "test_shard_5 100000\ntest_shard_0 10\ntest_missing 20\n");
+    for (size_t i = 6; i < SHARD_TESTS; i++)
+    {
+        fprintf(file, "test_shard_%lu %lu\n", (unsigned long) i, (unsigned long) (10U + i));
+    }
+    fclose(file);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        size_t total = 0;
+        for (size_t index = 0; index < counts[c]; index++)
+        {
+            const unsigned int before = runs[5];
+            size_t             ran;
+            runit_eq(runit_set_shard(index, counts[c], times), 0);
+            runit_eq(runit_shard_unplanned(), counts[c] > 1U ? UNPLANNED : 0U);
+            ran = runit_run_all();
+            if (counts[c] > 1U && runs[5] > before)
+            {
+                runit_eq(ran, 1U);  // Alone in its shard
+            }
+            total += ran;
+        }
+        runit_eq(total, SHARD_TESTS);
+        check_once();
+    }
+}
+
+static void test_main(const char* const times)
+{
+    char   shard[] = "1/4";
+    char*  argv[]  = {"runit-shards", "--shard", shard, NULL};
+    FILE*  file;
+    char   name[64];
+    long   microseconds;
+    size_t lines = 0;
+
+    runit_eq(runit_main(3, argv), 0);
+    runit_eq(runs[1] + runs[5] + runs[9] + runs[13] + runs[17] + runs[21], 6U);
+    for (size_t i = 0; i < SHARD_TESTS; i++)
+    {
+        runs[i] = 0;
+    }
+    shard[0] = '4';
+    runit_eq(runit_main(3, argv), 2);
+
+    // The same shards from the environment, saving the durations of all of them
+    setenv("RUNIT_SHARD_COUNT", "2", 1);
+    setenv("RUNIT_SHARD_TIMES", times, 1);
+    setenv("RUNIT_SHARD_TIMES_UPDATE", "1", 1);
+    setenv("RUNIT_SHARD_INDEX", "0", 1);
+    runit_eq(runit_main(1, argv), 0);
+    file = fopen(times, "r");
+    runit_assert(file != NULL);
+    while (fscanf(file, "%63s %ld", name, &microseconds) == 2)
+    {
+        lines++;
+    }
+    fclose(file);
+    setenv("RUNIT_SHARD_INDEX", "1", 1);
+    runit_eq(runit_main(1, argv), 0);
+    unsetenv("RUNIT_SHARD_INDEX");
+    unsetenv("RUNIT_SHARD_COUNT");
+    unsetenv("RUNIT_SHARD_TIMES");
+    unsetenv("RUNIT_SHARD_TIMES_UPDATE");
+    runit_eq(lines, (SHARD_TESTS + 1U) / 2U);
+    check_once();
+}
+
+int main(void)
+{
+    char times[] = "runit-shards-XXXXXX";
+
+    close(mkstemp(times));
+    runit_set_sink(discard_sink, NULL);
+    test_in_order();
+    test_balanced(times);
+    test_main(times);
+    runit_set_sink(NULL, NULL);
+    remove(times);
+    runit_report();
+    return runit_at_least_one_fail;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file
+ * Code size benchmark of the runit assertion macros.
+ *
+ * Compiled into objects only, which are measured by `size_bench.cmake`.
+ * The amount of assertions must match `RUNIT_SIZE_BENCH_ASSERTIONS` in the
+ * CMakeLists.txt file.
+ */
+
+#include "runit.h"
+
+/* Read through a volatile, so no assertion can be folded at compile time. */
+volatile int runit_size_bench_values[16];
+
+#if defined(RUNIT_SIZE_BENCH_INLINE_FAIL)
+/* Expansion of runit_assert() before the failure path was moved out of line,
+ * kept here only as the reference for the size comparison. The line number is
+ * a parameter, as in a real test suite every assertion is on its own line and
+ * the compiler cannot merge the printf() calls. */
+#    define runit_assert_inline(expression, line)                                         \
+        do                                                                                \
+        {                                                                                 \
+            if (!(expression))                                                            \
+            {                                                                             \
+                printf("FAIL | File: %s:%d | Test case: %s\n", __FILE__, line, __func__); \
+                runit_counter_assert_failures++;                                          \
+                runit_at_least_one_fail = 1;                                              \
+                return;                                                                   \
+            }                                                                             \
+            else                                                                          \
+            {                                                                             \
+                runit_counter_assert_passes++;                                            \
+            }                                                                             \
+        } while (0)
+#    define BENCH_ASSERT(i) runit_assert_inline(runit_size_bench_values[(i) % 16] == (i), __LINE__ + (i))
+#elif defined(RUNIT_SIZE_BENCH_EQ)
+/* With or without RUNIT_NO_VALUES, for the cost of capturing the operands. */
+#    define BENCH_ASSERT(i) runit_eq(runit_size_bench_values[(i) % 16], (i))
+#elif defined(RUNIT_SIZE_BENCH_EXPECT)
+#    define BENCH_ASSERT(i) runit_expect_assert(runit_size_bench_values[(i) % 16] == (i))
+#else
+#    define BENCH_ASSERT(i) runit_assert(runit_size_bench_values[(i) % 16] == (i))
+#endif
+
+#define BENCH_ASSERT4(i)  BENCH_ASSERT(i); BENCH_ASSERT((i) + 1); BENCH_ASSERT((i) + 2); BENCH_ASSERT((i) + 3)
+#define BENCH_ASSERT16(i) BENCH_ASSERT4(i); BENCH_ASSERT4((i) + 4); BENCH_ASSERT4((i) + 8); BENCH_ASSERT4((i) + 12)
+#define BENCH_ASSERT64(i)     \
+    BENCH_ASSERT16(i);        \
+    BENCH_ASSERT16((i) + 16); \
+    BENCH_ASSERT16((i) + 32); \
+    BENCH_ASSERT16((i) + 48)
+
+void runit_size_bench_0(void);
+void runit_size_bench_1(void);
+void runit_size_bench_2(void);
+void runit_size_bench_3(void);
+
+void runit_size_bench_0(void)
+{
+    BENCH_ASSERT64(0);
+}
+
+void runit_size_bench_1(void)
+{
+    BENCH_ASSERT64(64);
+}
+
+void runit_size_bench_2(void)
+{
+    BENCH_ASSERT64(128);
+}
+
+void runit_size_bench_3(void)
+{
+    BENCH_ASSERT64(192);
+}
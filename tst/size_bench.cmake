@@ -0,0 +1,97 @@
+# Compares the size of two builds of size_bench.c and reports the bytes spent
+# per assertion, as printed by `ctest -V`.
+#
+# Expected variables:
+#   SIZE_TOOL           the binutils `size` (or `llvm-size`) program
+#   ASSERTIONS          amount of assertions in size_bench.c
+#   BASELINE_LABEL      description of the reference build
+#   BASELINE_OBJECT     object file of the reference build
+#   CANDIDATE_LABEL     description of the build under test
+#   CANDIDATE_OBJECT    object file of the build under test
+# Optional variables:
+#   SECTION             `text` (default) or `rodata`, the compared sections
+#   ABSENT_STRING       text that must not be stored in the candidate object
+#   MAX_GROWTH          bytes per assertion the candidate may add
+#   MAX_COLD_GROWTH     bytes per assertion the candidate may add to .text.unlikely
+#
+# For `text`, code the compiler moved to .text.unlikely (cold paths) is
+# reported apart from the hot .text. The test fails if the hot code (or the
+# constant data) of the candidate is not smaller than the one of the baseline,
+# or with MAX_GROWTH, if it grew by more than that; with MAX_COLD_GROWTH, also
+# if its cold code grew by more than that.
+
+if (NOT DEFINED SECTION)
+    set(SECTION text)
+endif ()
+
+function(runit_section_bytes object hot_var cold_var)
+    execute_process(
+            COMMAND ${SIZE_TOOL} -A ${object}
+            OUTPUT_VARIABLE output
+            RESULT_VARIABLE result
+    )
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "Cannot read the sections of ${object}")
+    endif ()
+    string(REPLACE "\n" ";" lines "${output}")
+    set(hot 0)
+    set(cold 0)
+    foreach (line IN LISTS lines)
+        if (line MATCHES "^\\.${SECTION}\\.(unlikely|cold)[^ ]*[ ]+([0-9]+)")
+            math(EXPR cold "${cold} + ${CMAKE_MATCH_2}")
+        elseif (line MATCHES "^\\.${SECTION}[^ ]*[ ]+([0-9]+)")
+            math(EXPR hot "${hot} + ${CMAKE_MATCH_1}")
+        endif ()
+    endforeach ()
+    set(${hot_var} ${hot} PARENT_SCOPE)
+    set(${cold_var} ${cold} PARENT_SCOPE)
+endfunction()
+
+function(runit_per_assertion bytes out_var)
+    math(EXPR units "${bytes} / ${ASSERTIONS}")
+    math(EXPR tenths "(${bytes} * 10 / ${ASSERTIONS}) % 10")
+    set(${out_var} "${units}.${tenths}" PARENT_SCOPE)
+endfunction()
+
+function(runit_report_size label object out_var cold_var)
+    runit_section_bytes(${object} hot cold)
+    runit_per_assertion(${hot} hot_per_assertion)
+    if (SECTION STREQUAL "text")
+        runit_per_assertion(${cold} cold_per_assertion)
+        message(STATUS "SIZE | ${label}"
+                " | .text: ${hot} bytes, ${hot_per_assertion} per assertion"
+                " | .text.unlikely: ${cold} bytes, ${cold_per_assertion} per assertion")
+    else ()
+        message(STATUS "SIZE | ${label} | .${SECTION}: ${hot} bytes, ${hot_per_assertion} per assertion")
+    endif ()
+    set(${out_var} ${hot} PARENT_SCOPE)
+    set(${cold_var} ${cold} PARENT_SCOPE)
+endfunction()
+
+runit_report_size("${BASELINE_LABEL}" ${BASELINE_OBJECT} baseline_size baseline_cold)
+runit_report_size("${CANDIDATE_LABEL}" ${CANDIDATE_OBJECT} candidate_size candidate_cold)
+if (DEFINED MAX_GROWTH)
+    math(EXPR limit "${baseline_size} + ${MAX_GROWTH} * ${ASSERTIONS}")
+    if (candidate_size GREATER limit)
+        message(FATAL_ERROR "${CANDIDATE_LABEL} grew by more than ${MAX_GROWTH} bytes per assertion")
+    endif ()
+elseif (NOT candidate_size LESS baseline_size)
+    message(FATAL_ERROR "${CANDIDATE_LABEL} is not smaller than ${BASELINE_LABEL}")
+endif ()
+if (DEFINED MAX_COLD_GROWTH)
+    math(EXPR cold_growth "${candidate_cold} - ${baseline_cold}")
+    runit_per_assertion(${cold_growth} cold_growth_per_assertion)
+    message(STATUS "SIZE | ${CANDIDATE_LABEL} adds ${cold_growth_per_assertion} bytes of cold code per assertion"
+            " (at most ${MAX_COLD_GROWTH})")
+    math(EXPR cold_limit "${baseline_cold} + ${MAX_COLD_GROWTH} * ${ASSERTIONS}")
+    if (candidate_cold GREATER cold_limit)
+        message(FATAL_ERROR "${CANDIDATE_LABEL} grew its cold code by more than ${MAX_COLD_GROWTH} bytes per assertion")
+    endif ()
+endif ()
+if (DEFINED ABSENT_STRING)
+    string(REGEX REPLACE "([][+.*()^$?|\\])" "\\\\\\1" absent_regex "${ABSENT_STRING}")
+    file(STRINGS ${CANDIDATE_OBJECT} found REGEX "${absent_regex}")
+    if (found)
+        message(FATAL_ERROR "${CANDIDATE_LABEL} still stores \"${ABSENT_STRING}\"")
+    endif ()
+endif ()
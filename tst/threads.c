@@ -0,0 +1,71 @@
+/**
+ * @file
+ * Self-test of the thread-safe mode: many threads asserting at once must not
+ * lose any count. Built with RUNIT_THREAD_SAFE and fewer thread slots than
+ * threads, so the shared slot is exercised too.
+ */
+
+#include "runit.h"
+#include <pthread.h>
+
+#define THREADS             32U
+#define PASSES_PER_THREAD   200000U
+#define FAILURES_PER_THREAD 100U
+#define MERGE_EVERY         10000U
+
+static void discard_sink(void* context, const char* record, size_t length)
+{
+    (void) context;
+    (void) record;
+    (void) length;
+}
+
+static void fail_once(void)
+{
+    runit_fail();
+}
+
+static void assert_many(void)
+{
+    for (unsigned int i = 0; i < PASSES_PER_THREAD; i++)
+    {
+        runit_true(1);
+        if (i % MERGE_EVERY == 0)
+        {
+            runit_counters_merge();  // Concurrently with the other threads
+        }
+    }
+}
+
+static void* hammer(void* argument)
+{
+    (void) argument;
+    for (unsigned int i = 0; i < FAILURES_PER_THREAD; i++)
+    {
+        fail_once();
+    }
+    assert_many();
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t threads[THREADS];
+
+    runit_set_sink(discard_sink, NULL);
+    for (unsigned int i = 0; i < THREADS; i++)
+    {
+        if (pthread_create(&threads[i], NULL, hammer, NULL) != 0)
+        {
+            return 1;
+        }
+    }
+    for (unsigned int i = 0; i < THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    runit_set_sink(NULL, NULL);
+    runit_report();
+    return runit_counter_assert_passes != THREADS * PASSES_PER_THREAD
+           || runit_counter_assert_failures != THREADS * FAILURES_PER_THREAD || !runit_at_least_one_fail;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file
+ * Self-test of the timeouts: a test case spinning forever and one blocked in
+ * a system call are stopped and reported, the following test cases still
+ * run; the limit of the whole run stops the remaining ones.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "runit.h"
+#include <stdint.h> /* For intptr_t */
+#include <stdio.h>  /* For remove() */
+#include <stdlib.h> /* For mkstemp() */
+#include <string.h> /* For strstr() */
+#include <unistd.h> /* For pause(), read(), close() */
+
+#define TEST_LIMIT_MS 50U
+
+static unsigned int finished;
+static size_t       spin_index = RUNIT_NO_TEST;
+
+RUNIT_TEST(test_spin_forever)
+{
+    volatile unsigned int forever = 1;
+
+    spin_index = runit_current_test();
+    while (forever)
+    {
+    }
+}
+
+RUNIT_TEST(test_blocked)
+{
+    pause();
+}
+
+RUNIT_TEST(test_finishes)
+{
+    finished++;
+}
+
+static void test_each_test_case(void)
+{
+    static char output[RUNIT_SINK_RING_SIZE + 1U];
+    size_t      length;
+
+    runit_eq(runit_set_timeout(TEST_LIMIT_MS, 0), 0);
+    runit_set_sink(runit_sink_ring, NULL);
+    runit_eq(runit_run_all(), 3U);
+    runit_set_sink(NULL, NULL);
+    runit_counters_merge();
+    runit_eq(runit_counter_assert_failures, 2U);
+    runit_eq(finished, 1U);
+    runit_lt(spin_index, runit_test_count());
+    runit_eq(runit_current_test(), RUNIT_NO_TEST);
+    runit_ge(runit_test_time(spin_index), TEST_LIMIT_MS * 1000U);
+    length         = runit_sink_ring_read(output, sizeof(output) - 1U);
+    output[length] = '\0';
+    runit_assert(strstr(output, "TIMEOUT | File: ") == output);
+    runit_assert(strstr(output, "| Test case: test_spin_forever | Elapsed: ") != NULL);
+    runit_assert(strstr(output, "| Test case: test_blocked | Elapsed: ") != NULL);
+    runit_assert(strstr(output, "| Limit: 50 ms\n") != NULL);
+    runit_counter_assert_failures = 0;  // Expected ones
+    runit_at_least_one_fail       = 0;
+}
+
+static void test_whole_run(void)
+{
+    static char output[RUNIT_SINK_RING_SIZE + 1U];
+    size_t      length;
+
+    finished = 0;
+    runit_eq(runit_set_timeout(0, TEST_LIMIT_MS), 0);
+    runit_set_sink(runit_sink_ring, NULL);
+    runit_le(runit_run_all(), 1U);  // The remaining ones do not run
+    runit_set_sink(NULL, NULL);
+    runit_counters_merge();
+    runit_eq(runit_counter_assert_failures, 1U);
+    runit_eq(finished, 0U);
+    length         = runit_sink_ring_read(output, sizeof(output) - 1U);
+    output[length] = '\0';
+    runit_assert(strstr(output, "| Limit: 50 ms for all test cases\n") != NULL);
+    runit_counter_assert_failures = 0;  // Expected one
+    runit_at_least_one_fail       = 0;
+    runit_eq(runit_set_timeout(0, 0), 0);
+}
+
+#if RUNIT_HAVE_PARALLEL && RUNIT_HAVE_SINK_FD
+static void test_whole_run_parallel(void)
+{
+    static char  output[4096];
+    char         path[] = "/tmp/runit-timeouts-XXXXXX";
+    char*        argv[] = {"runit-timeouts", "-j", "3", "--total-timeout", "50", NULL};
+    const int    fd     = mkstemp(path);
+    unsigned int count  = 0;
+    ssize_t      length;
+
+    runit_assert(fd >= 0);
+    runit_set_sink(runit_sink_fd, (void*) (intptr_t) fd);  // The workers inherit it
+    runit_eq(runit_main(5, argv), 1);  // Both hanging test cases reach the end of the run
+    runit_set_sink(NULL, NULL);
+    runit_counters_merge();
+    runit_eq(runit_counter_assert_failures, 1U);  // Only one worker reports it
+    length = pread(fd, output, sizeof(output) - 1U, 0);
+    runit_gt(length, 0);
+    output[length > 0 ? length : 0] = '\0';
+    for (const char* found = output; (found = strstr(found, "for all test cases")) != NULL; found++)
+    {
+        count++;
+    }
+    runit_eq(count, 1U);
+    close(fd);
+    remove(path);
+    runit_counter_assert_failures = 0;  // Expected one
+    runit_at_least_one_fail       = 0;
+    runit_eq(runit_set_timeout(0, 0), 0);
+}
+#endif
+
+int main(void)
+{
+    test_each_test_case();
+    test_whole_run();
+#if RUNIT_HAVE_PARALLEL && RUNIT_HAVE_SINK_FD
+    test_whole_run_parallel();
+#endif
+    runit_report();
+    return runit_at_least_one_fail;
+}
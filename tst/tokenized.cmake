@@ -0,0 +1,36 @@
+# Runs the selftest in text mode and in tokenized mode, decodes the tokenized
+# output with tools/runit_detokenize.py and requires both to be identical.
+#
+# Expected variables:
+#   PYTHON              Python 3 interpreter
+#   DECODER             path of runit_detokenize.py
+#   DECODER_ARGS        extra arguments of the decoder (optional)
+#   TEXT_EXECUTABLE     selftest printing text
+#   TOKEN_EXECUTABLE    same selftest built with RUNIT_TOKENIZED
+#   WORK_DIR            directory for the captured binary stream
+
+set(stream ${WORK_DIR}/runit-tokenized.bin)
+
+execute_process(COMMAND ${TEXT_EXECUTABLE} OUTPUT_VARIABLE text RESULT_VARIABLE text_result)
+execute_process(COMMAND ${TOKEN_EXECUTABLE} OUTPUT_FILE ${stream} RESULT_VARIABLE token_result)
+if (NOT text_result EQUAL 0 OR NOT token_result EQUAL 0)
+    message(FATAL_ERROR "Selftest failed: text mode ${text_result}, tokenized mode ${token_result}")
+endif ()
+
+execute_process(
+        COMMAND ${PYTHON} ${DECODER} ${DECODER_ARGS} ${TOKEN_EXECUTABLE} ${stream}
+        OUTPUT_VARIABLE decoded
+        RESULT_VARIABLE decode_result
+)
+if (NOT decode_result EQUAL 0)
+    message(FATAL_ERROR "Decoding ${stream} failed")
+endif ()
+
+file(SIZE ${stream} token_size)
+string(LENGTH "${text}" text_size)
+message(STATUS "Text output: ${text_size} bytes, tokenized output: ${token_size} bytes")
+if (NOT decoded STREQUAL text)
+    file(WRITE ${WORK_DIR}/runit-tokenized-decoded.txt "${decoded}")
+    file(WRITE ${WORK_DIR}/runit-tokenized-expected.txt "${text}")
+    message(FATAL_ERROR "Decoded output differs from the text output, see ${WORK_DIR}/runit-tokenized-*.txt")
+endif ()